@@ -0,0 +1,35 @@
+#include "alloccheck.h"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#ifdef KOMBAT_ALLOC_CHECK
+
+static thread_local uint64_t g_allocs = 0;
+
+uint64_t allocCount() { return g_allocs; }
+
+// The array and nothrow forms call these by default, so replacing the basic
+// pair covers every non-aligned new and delete.
+void* operator new(size_t size) {
+    ++g_allocs;
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+#else
+
+uint64_t allocCount() { return 0; }
+
+#endif
+
+AllocCheckScope::~AllocCheckScope() {
+    uint64_t n = allocCount() - start;
+    if (n == 0) return;
+    fprintf(stderr, "%s: %llu heap allocations\n", name, (unsigned long long)n);
+    assert(n == 0);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+// Heap allocation counting for debug builds. With KOMBAT_ALLOC_CHECK defined,
+// alloccheck.cpp replaces the global operator new to count allocations per
+// thread, and ALLOC_CHECK_SCOPE asserts that the enclosing scope made none.
+// Other threads (the asset loader) do not count against the scope. Without
+// the define the macro expands to nothing.
+
+// Allocations made by the calling thread so far; always 0 without KOMBAT_ALLOC_CHECK.
+uint64_t allocCount();
+
+class AllocCheckScope {
+private:
+    const char* name;
+    uint64_t start;
+public:
+    explicit AllocCheckScope(const char* n) : name(n), start(allocCount()) {}
+    ~AllocCheckScope();
+};
+
+#ifdef KOMBAT_ALLOC_CHECK
+#define ALLOC_CHECK_CONCAT2(a, b) a##b
+#define ALLOC_CHECK_CONCAT(a, b) ALLOC_CHECK_CONCAT2(a, b)
+#define ALLOC_CHECK_SCOPE(name) AllocCheckScope ALLOC_CHECK_CONCAT(allocCheckScope, __LINE__)(name)
+#else
+#define ALLOC_CHECK_SCOPE(name) ((void)0)
+#endif
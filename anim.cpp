@@ -0,0 +1,247 @@
+#include "anim.h"
+#include "png.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+static const char* const STATE_NAMES[ANIM_STATES] = { "idle", "punching", "ko" };
+
+AnimationSet::AnimationSet() {
+    clear();
+}
+
+void AnimationSet::clear() {
+    names.clear();
+    clips.clear();
+    ticks.clear();
+    for (int s = 0; s < ANIM_SLOTS; ++s)
+        for (int a = 0; a < ANIM_STATES; ++a) bound[s][a] = NO_CLIP;
+}
+
+ClipId AnimationSet::addClip(const std::string& name, const std::vector<TextureId>& cells, int ticksPerCell, bool loop) {
+    AnimClip clip;
+    clip.first = (uint32_t)ticks.size();
+    clip.length = (uint16_t)(cells.size() * ticksPerCell);
+    clip.loop = loop ? 1 : 0;
+    for (TextureId t : cells)
+        ticks.insert(ticks.end(), ticksPerCell, t);
+    names.push_back(name);
+    clips.push_back(clip);
+    return (ClipId)(clips.size() - 1);
+}
+
+ClipId AnimationSet::find(const std::string& name) const {
+    for (size_t c = 0; c < names.size(); ++c)
+        if (names[c] == name) return (ClipId)c;
+    return NO_CLIP;
+}
+
+bool AnimationSet::cutSheet(const std::string& sheetPath, int cols, int rows, const std::string& cacheDir,
+    SpriteBatch& batch, std::vector<TextureId>& cells) {
+    cells.clear();
+    if (cols == 1 && rows == 1) {
+        cells.push_back(batch.registerTexture(sheetPath));
+        return true;
+    }
+
+    // Cells are named <stem>_<path hash>_<cols>x<rows>_<i>.png, so sheets
+    // of the same name in different directories, or one sheet cut two ways,
+    // never share a file. They are reused while they are newer than the sheet
+    // and have the cell size the sheet splits into now.
+    uint32_t pathHash = 2166136261u;
+    for (char c : sheetPath) pathHash = (pathHash ^ (uint8_t)c) * 16777619u;
+    char tag[32];
+    snprintf(tag, sizeof(tag), "_%08x_%dx%d_", pathHash, cols, rows);
+    std::error_code ec;
+    fs::file_time_type sheetTime = fs::last_write_time(sheetPath, ec);
+    std::string stem = fs::path(sheetPath).stem().string();
+    std::vector<std::string> cellPaths;
+    bool fresh = !ec;
+    int sheetWidth = 0, sheetHeight = 0, cellWidth = 0, cellHeight = 0;
+    if (!readPngSize(sheetPath, sheetWidth, sheetHeight)) fresh = false;
+    for (int i = 0; i < cols * rows; ++i) {
+        cellPaths.push_back((fs::path(cacheDir) / (stem + tag + std::to_string(i) + ".png")).string());
+        if (!fresh) continue;
+        fs::file_time_type t = fs::last_write_time(cellPaths.back(), ec);
+        if (ec || t < sheetTime) fresh = false;
+        else if (!readPngSize(cellPaths.back(), cellWidth, cellHeight) || cellWidth * cols != sheetWidth
+            || cellHeight * rows != sheetHeight) fresh = false;
+    }
+
+    if (!fresh) {
+        Image sheet;
+        if (!loadPng(sheetPath, sheet)) {
+            error = "cannot decode " + sheetPath;
+            return false;
+        }
+        if (sheet.width % cols || sheet.height % rows) {
+            error = sheetPath + " does not split into " + std::to_string(cols) + "x" + std::to_string(rows) + " cells";
+            return false;
+        }
+        fs::create_directories(cacheDir, ec);
+        Image cell;
+        cell.width = sheet.width / cols;
+        cell.height = sheet.height / rows;
+        for (int i = 0; i < cols * rows; ++i) {
+            int x0 = (i % cols) * cell.width, y0 = (i / cols) * cell.height;
+            cell.rgba.clear();
+            for (int y = 0; y < cell.height; ++y) {
+                const uint8_t* row = &sheet.rgba[((size_t)(y0 + y) * sheet.width + x0) * 4];
+                cell.rgba.insert(cell.rgba.end(), row, row + cell.width * 4);
+            }
+            if (!savePng(cellPaths[i], cell)) {
+                error = "cannot write " + cellPaths[i];
+                return false;
+            }
+        }
+    }
+    for (int i = 0; i < cols * rows; ++i)
+        cells.push_back(batch.registerCell(sheetPath, i % cols, i / cols, cols, rows, cellPaths[i]));
+    return true;
+}
+
+bool AnimationSet::parse(const std::string& text, SpriteBatch& batch, const AssetManager& assets, const std::string& cacheDir) {
+    struct ClipDef {
+        std::string name, sheet;
+        int cols = 1, rows = 1, ticksPerCell = 1;
+        std::vector<int> frames;
+        bool loop = false;
+        int line;
+    };
+    struct BindDef {
+        int slot, state, line;
+        std::string clip;
+    };
+    std::vector<ClipDef> defs;
+    std::vector<BindDef> binds;
+    std::istringstream lines(text);
+    std::string line;
+    int lineNo = 0;
+    auto fail = [&](int at, const std::string& what) {
+        error = "line " + std::to_string(at) + ": " + what;
+        return false;
+    };
+
+    while (std::getline(lines, line)) {
+        ++lineNo;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.resize(hash);
+        std::istringstream in(line);
+        std::string key;
+        if (!(in >> key)) continue;
+        if (key == "clip") {
+            ClipDef d;
+            d.line = lineNo;
+            if (!(in >> d.name >> d.sheet)) return fail(lineNo, "clip needs a name and a sheet");
+            if (in >> d.cols) {
+                if (!(in >> d.rows) || d.cols <= 0 || d.rows <= 0) return fail(lineNo, "bad sheet size");
+            }
+            defs.push_back(d);
+            continue;
+        }
+        if (key == "bind") {
+            BindDef b;
+            b.line = lineNo;
+            std::string player, state;
+            if (!(in >> player >> state >> b.clip)) return fail(lineNo, "bind needs a player, a state and a clip");
+            if (player == "p1") b.slot = 0;
+            else if (player == "p2") b.slot = 1;
+            else return fail(lineNo, "unknown player");
+            b.state = -1;
+            for (int a = 0; a < ANIM_STATES; ++a)
+                if (state == STATE_NAMES[a]) b.state = a;
+            if (b.state < 0) return fail(lineNo, "unknown state");
+            binds.push_back(b);
+            continue;
+        }
+        if (defs.empty()) return fail(lineNo, "expected 'clip <name> <sheet>' first");
+        ClipDef& d = defs.back();
+        bool ok = true;
+        if (key == "frames") {
+            int f;
+            d.frames.clear();
+            while (in >> f) {
+                if (f < 0 || f >= d.cols * d.rows) return fail(lineNo, "frame outside the sheet");
+                d.frames.push_back(f);
+            }
+            ok = in.eof() && !d.frames.empty();
+        }
+        else if (key == "ticks") ok = (bool)(in >> d.ticksPerCell) && d.ticksPerCell > 0;
+        else if (key == "loop") d.loop = true;
+        else return fail(lineNo, "unknown key");
+        if (!ok) return fail(lineNo, "bad value");
+    }
+
+    size_t total = ticks.size();
+    for (const ClipDef& d : defs) {
+        size_t cells = d.frames.empty() ? (size_t)(d.cols * d.rows) : d.frames.size();
+        if (cells * d.ticksPerCell > 65535) return fail(d.line, "clip longer than 65535 ticks");
+        total += cells * d.ticksPerCell;
+    }
+    if (total > 0xffffffffu || clips.size() + defs.size() >= NO_CLIP) {
+        error = "too many clips";
+        return false;
+    }
+
+    std::vector<TextureId> cells, shown;
+    for (const ClipDef& d : defs) {
+        TextureHandle sheet = assets.findTexture(d.sheet);
+        if (!sheet.isValid()) return fail(d.line, "no texture named " + d.sheet);
+        if (!cutSheet(assets.getPath(sheet), d.cols, d.rows, cacheDir, batch, cells))
+            return fail(d.line, error);
+        if (d.frames.empty()) shown = cells;
+        else {
+            shown.clear();
+            for (int f : d.frames) shown.push_back(cells[f]);
+        }
+        addClip(d.name, shown, d.ticksPerCell, d.loop);
+    }
+    for (const BindDef& b : binds) {
+        ClipId c = find(b.clip);
+        if (c == NO_CLIP) return fail(b.line, "no clip named " + b.clip);
+        bound[b.slot][b.state] = c;
+    }
+    error.clear();
+    return true;
+}
+
+bool AnimationSet::load(const std::string& path, SpriteBatch& batch, const AssetManager& assets, const std::string& cacheDir) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    if (!parse(text.str(), batch, assets, cacheDir)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+void AnimationSet::useDefaults(SpriteBatch& batch, const AssetManager& assets) {
+    clear();
+    static const char* const files[ANIM_STATES] = { "idle", "punch", "ko" };
+    for (int s = 0; s < ANIM_SLOTS; ++s) {
+        for (int a = 0; a < ANIM_STATES; ++a) {
+            std::string name = "player" + std::to_string(s + 1) + "_" + files[a];
+            std::vector<TextureId> cell(1, batch.registerTexture(assets.getPath(assets.findTexture(name))));
+            bound[s][a] = addClip(name, cell, 1, true);
+        }
+    }
+}
+
+void AnimPlayer::step(const AnimationSet& set, const ClipId* wanted, uint32_t delta) {
+    size_t n = clip.size();
+    for (size_t i = 0; i < n; ++i) {
+        if (wanted[i] != clip[i]) {
+            clip[i] = wanted[i];
+            tick[i] = 0;
+        }
+        else if (clip[i] != NO_CLIP) tick[i] = set.advance(clip[i], tick[i], delta);
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "assets.h"
+#include "sim.h"
+#include "spritebatch.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Sprite animation clips advanced by the fixed sim tick. A clip is stored as
+// the texture to show on each of its ticks, all clips back to back in one
+// table, so playing a frame is clip start + tick and a single load. The
+// soft backend draws each cell from its region of the sheet in the sprite
+// atlas; SGG draws it from a file of its own (see below).
+//
+// Clips file format, one entry per line, '#' starts a comment:
+//   clip p1_walk player1_walk 4 2   name, sheet asset, then columns and rows
+//   frames 0 1 2 3 2 1              cells to show in order (default: all)
+//   ticks 10                        sim ticks per cell (default 1)
+//   loop                            wrap around instead of holding the last cell
+//   bind p1 idle p1_walk            play this clip for a fighter's AnimState
+// Sheets are cut row by row into equal cells. SGG can only bind whole image
+// files, so each cell of a sheet with more than one is written to the cache
+// directory as its own PNG the first time it is needed.
+
+typedef uint16_t ClipId;
+const ClipId NO_CLIP = 0xffff;
+const int ANIM_SLOTS = 2;
+const int ANIM_STATES = 3;
+
+struct AnimClip {
+    uint32_t first;    // its first entry in the tick table
+    uint16_t length;   // in ticks
+    uint8_t loop;
+};
+
+class AnimationSet {
+private:
+    std::vector<std::string> names;
+    std::vector<AnimClip> clips;
+    std::vector<TextureId> ticks;
+    ClipId bound[ANIM_SLOTS][ANIM_STATES];
+    std::string error;
+
+    bool cutSheet(const std::string& sheetPath, int cols, int rows, const std::string& cacheDir,
+        SpriteBatch& batch, std::vector<TextureId>& cells);
+public:
+    AnimationSet();
+
+    // One texture per cell; each is shown for ticksPerCell ticks.
+    ClipId addClip(const std::string& name, const std::vector<TextureId>& cells, int ticksPerCell, bool loop);
+    void bind(int slot, AnimState state, ClipId clip) { bound[slot][(int)state] = clip; }
+    ClipId getBound(int slot, AnimState state) const { return bound[slot][(int)state]; }
+    ClipId find(const std::string& name) const;
+    const AnimClip& getClip(ClipId c) const { return clips[c]; }
+    size_t getClipCount() const { return clips.size(); }
+
+    // Tick t of clip c moved on by delta: wraps for looping clips and holds on
+    // the last tick otherwise.
+    uint32_t advance(ClipId c, uint32_t t, uint32_t delta) const {
+        const AnimClip& clip = clips[c];
+        t += delta;
+        if (t >= clip.length) t = clip.loop ? t % clip.length : clip.length - 1u;
+        return t;
+    }
+    TextureId getTexture(ClipId c, uint32_t t) const { return ticks[clips[c].first + t]; }
+
+    // Adds the clips in the file, registering their textures with the batch.
+    // False sets getError() and may leave some clips added.
+    bool parse(const std::string& text, SpriteBatch& batch, const AssetManager& assets, const std::string& cacheDir);
+    bool load(const std::string& path, SpriteBatch& batch, const AssetManager& assets, const std::string& cacheDir);
+    // Drops every clip and binding.
+    void clear();
+    // One-cell clips of the idle, punch and KO images.
+    void useDefaults(SpriteBatch& batch, const AssetManager& assets);
+    const std::string& getError() const { return error; }
+};
+
+// Playback state for any number of sprites, one clip and tick per entity.
+class AnimPlayer {
+private:
+    std::vector<ClipId> clip;
+    std::vector<uint32_t> tick;
+public:
+    void resize(size_t n) {
+        clip.assign(n, NO_CLIP);
+        tick.assign(n, 0);
+    }
+    size_t size() const { return clip.size(); }
+    // Moves every entity on by delta ticks. wanted[i] is the clip entity i
+    // should be playing; a change restarts it from tick 0.
+    void step(const AnimationSet& set, const ClipId* wanted, uint32_t delta);
+    TextureId getTexture(const AnimationSet& set, size_t i) const {
+        return clip[i] == NO_CLIP ? NO_TEXTURE : set.getTexture(clip[i], tick[i]);
+    }
+};
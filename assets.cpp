@@ -0,0 +1,182 @@
+#include "assets.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+static double nowMs() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+static AssetType typeFromExtension(std::string ext) {
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) { return (char)tolower(c); });
+    if (ext == ".png") return AssetType::TEXTURE;
+    if (ext == ".ttf" || ext == ".otf") return AssetType::FONT;
+    if (ext == ".mp3" || ext == ".wav" || ext == ".ogg") return AssetType::SOUND;
+    return AssetType::OTHER;
+}
+
+bool AssetManager::scan(const std::string& dir) {
+    double start = nowMs();
+    entries.clear();
+    pack.close();
+    std::error_code ec;
+    for (const auto& item : std::filesystem::directory_iterator(dir, ec)) {
+        if (!item.is_regular_file()) continue;
+        Entry e;
+        e.name = item.path().stem().string();
+        // Keep the separator style the rest of the game uses for SGG paths.
+#ifdef _WIN32
+        e.path = dir + "\\" + item.path().filename().string();
+#else
+        e.path = dir + "/" + item.path().filename().string();
+#endif
+        e.type = typeFromExtension(item.path().extension().string());
+        entries.push_back(std::move(e));
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.path < b.path; });
+    scanMs = nowMs() - start;
+    return !ec;
+}
+
+void AssetManager::load(Entry& e) {
+    double start = nowMs();
+    FILE* f = fopen(e.path.c_str(), "rb");
+    if (!f) return;
+    std::vector<uint8_t> data;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (e.type == AssetType::SOUND) {
+        // Sounds are played from their files, so only the header is read to
+        // check the format, and nothing is kept.
+        uint8_t head[4];
+        e.fileBytes = size > 0 ? (size_t)size : 0;
+        size_t got = fread(head, 1, sizeof(head), f);
+        fclose(f);
+        // ID3 tag or an MPEG frame sync, RIFF (WAV) or Ogg.
+        e.ok = got == sizeof(head) && (memcmp(head, "ID3", 3) == 0 || (head[0] == 0xff && (head[1] & 0xe0) == 0xe0) ||
+            memcmp(head, "RIFF", 4) == 0 || memcmp(head, "OggS", 4) == 0);
+        e.loadMs = nowMs() - start;
+        return;
+    }
+    if (size > 0) {
+        data.resize((size_t)size);
+        data.resize(fread(data.data(), 1, data.size(), f));
+    }
+    fclose(f);
+    e.fileBytes = data.size();
+
+    switch (e.type) {
+    case AssetType::TEXTURE:
+        if (!decodeTextures) {
+            e.ok = data.size() >= 8 && memcmp(data.data(), "\x89PNG", 4) == 0;
+            e.loadMs = nowMs() - start;
+            return;
+        }
+        e.ok = decodePng(data.data(), data.size(), e.image);
+        e.data = e.image.rgba.data();
+        e.dataSize = e.image.rgba.size();
+        e.width = e.image.width;
+        e.height = e.image.height;
+        e.loadMs = nowMs() - start;
+        return;
+    case AssetType::FONT:
+        // TrueType or CFF sfnt header.
+        e.ok = data.size() >= 12 && (memcmp(data.data(), "\0\1\0\0", 4) == 0 ||
+            memcmp(data.data(), "OTTO", 4) == 0 || memcmp(data.data(), "true", 4) == 0);
+        break;
+    default:
+        e.ok = true;
+        break;
+    }
+    e.bytes.swap(data);
+    e.data = e.bytes.data();
+    e.dataSize = e.bytes.size();
+    e.loadMs = nowMs() - start;
+}
+
+void AssetManager::work() {
+    for (;;) {
+        size_t job = nextJob.fetch_add(1);
+        if (job >= entries.size()) return;
+        load(entries[job]);
+        if (finished.fetch_add(1) + 1 == entries.size())
+            loadWallMs = nowMs() - loadStart;
+    }
+}
+
+void AssetManager::startLoading(int threads) {
+    wait();
+    if (threads <= 0) {
+        int cores = (int)std::thread::hardware_concurrency();
+        threads = cores > 1 ? cores - 1 : 1;
+    }
+    if (threads > (int)entries.size()) threads = (int)entries.size();
+    nextJob = 0;
+    finished = 0;
+    loadStart = nowMs();
+    for (int i = 0; i < threads; ++i)
+        workers.emplace_back(&AssetManager::work, this);
+}
+
+bool AssetManager::openPack(const std::string& packPath, const std::string& dir) {
+    wait();
+    double start = nowMs();
+    entries.clear();
+    if (!pack.open(packPath)) return false;
+    for (uint32_t i = 0; i < pack.getCount(); ++i) {
+        const PackEntry& pe = pack.getEntry(i);
+        std::string fileName = pe.fileName;
+        Entry e;
+        size_t dot = fileName.rfind('.');
+        e.name = fileName.substr(0, dot);
+#ifdef _WIN32
+        e.path = dir + "\\" + fileName;
+#else
+        e.path = dir + "/" + fileName;
+#endif
+        e.type = (AssetType)pe.type;
+        e.data = pack.getData(i);
+        e.dataSize = (size_t)pe.size;
+        e.fileBytes = e.dataSize;
+        e.width = (int)pe.width;
+        e.height = (int)pe.height;
+        e.ok = e.type != AssetType::TEXTURE || (PackFormat)pe.format == PackFormat::RGBA8;
+        entries.push_back(std::move(e));
+    }
+    nextJob = entries.size();
+    finished = entries.size();
+    scanMs = 0.0;
+    loadWallMs = nowMs() - start;
+    return true;
+}
+
+void AssetManager::wait() {
+    for (auto& t : workers) t.join();
+    workers.clear();
+}
+
+uint16_t AssetManager::find(const std::string& name, AssetType type) const {
+    for (size_t i = 0; i < entries.size(); ++i)
+        if (entries[i].type == type && entries[i].name == name) return (uint16_t)i;
+    return 0xffff;
+}
+
+TextureHandle AssetManager::findTexturePath(const std::string& path) const {
+    for (size_t i = 0; i < entries.size(); ++i)
+        if (entries[i].type == AssetType::TEXTURE && entries[i].path == path) return { (uint16_t)i };
+    return {};
+}
+
+void AssetManager::printReport() const {
+    size_t bytes = 0;
+    for (const Entry& e : entries) {
+        bytes += e.fileBytes;
+        printf("  %-28s %8zu bytes %7.2f ms %s\n", e.path.c_str(), e.fileBytes, e.loadMs, e.ok ? "" : "FAILED");
+    }
+    printf("assets: %zu files, %.1f KB, scan %.2f ms, background load %.2f ms\n",
+        entries.size(), bytes / 1024.0, scanMs, loadWallMs);
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "pack.h"
+#include "png.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Scans the asset folder once at startup and decodes everything on a small
+// pool of worker threads while the menu is up, or maps a prebuilt pack file
+// (see pack.h) and skips decoding altogether. Assets are looked up by file
+// name without extension and referenced afterwards through typed integer
+// handles.
+
+enum class AssetType : uint8_t { TEXTURE, FONT, SOUND, OTHER };
+
+template <AssetType T>
+struct AssetHandle {
+    uint16_t index = 0xffff;
+    bool isValid() const { return index != 0xffff; }
+};
+typedef AssetHandle<AssetType::TEXTURE> TextureHandle;
+typedef AssetHandle<AssetType::FONT> FontHandle;
+typedef AssetHandle<AssetType::SOUND> SoundHandle;
+
+struct ImageView {
+    int width = 0, height = 0;
+    const uint8_t* rgba = nullptr;   // null when the image is not available
+};
+
+class AssetManager {
+private:
+    struct Entry {
+        std::string name, path;
+        AssetType type;
+        size_t fileBytes = 0;
+        bool ok = false;
+        double loadMs = 0.0;
+        Image image;                  // decoded pixels when loaded from loose files
+        std::vector<uint8_t> bytes;   // raw contents of fonts and other files
+        // Loaded contents: decoded RGBA for textures, none for sounds (they
+        // are played from their files), file bytes otherwise. Points into
+        // image/bytes or into the mapped pack.
+        const uint8_t* data = nullptr;
+        size_t dataSize = 0;
+        int width = 0, height = 0;
+    };
+    std::vector<Entry> entries;
+    PackFile pack;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> nextJob{ 0 }, finished{ 0 };
+    double scanMs = 0.0, loadWallMs = 0.0;
+    double loadStart = 0.0;
+    bool decodeTextures = true;
+    std::string noPath;
+
+    void work();
+    void load(Entry& e);
+    uint16_t find(const std::string& name, AssetType type) const;
+public:
+    ~AssetManager() { wait(); }
+
+    // Lists the files in dir. Must be called before startLoading().
+    bool scan(const std::string& dir);
+    // Off: textures are only read and checked, for backends that load image
+    // files themselves. Set before startLoading().
+    void setDecodeTextures(bool decode) { decodeTextures = decode; }
+    // Spawns the workers; threads <= 0 uses one less than the core count.
+    void startLoading(int threads = 0);
+    // Maps a pack file instead of scanning; assets are ready on return. SGG
+    // still loads textures and sounds by path, so paths are built against dir.
+    bool openPack(const std::string& packPath, const std::string& dir);
+    bool isLoaded() const { return finished.load() == entries.size(); }
+    void wait();
+
+    TextureHandle findTexture(const std::string& name) const { return { find(name, AssetType::TEXTURE) }; }
+    FontHandle findFont(const std::string& name) const { return { find(name, AssetType::FONT) }; }
+    SoundHandle findSound(const std::string& name) const { return { find(name, AssetType::SOUND) }; }
+    // The texture whose getPath() is path.
+    TextureHandle findTexturePath(const std::string& path) const;
+
+    template <AssetType T>
+    const std::string& getPath(AssetHandle<T> h) const { return h.isValid() ? entries[h.index].path : noPath; }
+    // Decoded pixels; empty until loading has finished.
+    ImageView getImage(TextureHandle h) const {
+        ImageView view;
+        if (h.isValid() && isLoaded() && entries[h.index].ok) {
+            const Entry& e = entries[h.index];
+            view.width = e.width;
+            view.height = e.height;
+            view.rgba = e.data;
+        }
+        return view;
+    }
+
+    size_t getCount() const { return entries.size(); }
+    // Raw access by index, for tools that walk every asset once loading has finished.
+    const std::string& getName(size_t i) const { return entries[i].name; }
+    const std::string& getPathAt(size_t i) const { return entries[i].path; }
+    AssetType getType(size_t i) const { return entries[i].type; }
+    bool isOk(size_t i) const { return entries[i].ok; }
+    const uint8_t* getData(size_t i, size_t& size, int& width, int& height) const {
+        size = entries[i].dataSize;
+        width = entries[i].width;
+        height = entries[i].height;
+        return entries[i].data;
+    }
+    void printReport() const;
+};
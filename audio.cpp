@@ -0,0 +1,447 @@
+#include "audio.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+namespace {
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t readLE32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint16_t readLE16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+struct WavFormat {
+    int channels = 0, rate = 0;
+    long dataStart = 0;
+    uint32_t dataBytes = 0;
+};
+
+// Walks the RIFF chunks up to "data", leaving the file positioned at the
+// first sample. Only 16-bit PCM (plain or extensible) is accepted.
+bool readWavHeader(FILE* f, WavFormat& fmt) {
+    uint8_t head[12];
+    if (fread(head, 1, 12, f) != 12 || memcmp(head, "RIFF", 4) || memcmp(head + 8, "WAVE", 4)) return false;
+    bool haveFormat = false;
+    uint8_t chunk[8];
+    while (fread(chunk, 1, 8, f) == 8) {
+        uint32_t size = readLE32(chunk + 4);
+        if (!memcmp(chunk, "fmt ", 4)) {
+            uint8_t body[16];
+            if (size < 16 || fread(body, 1, 16, f) != 16) return false;
+            uint16_t format = readLE16(body);
+            fmt.channels = readLE16(body + 2);
+            fmt.rate = (int)readLE32(body + 4);
+            int bits = readLE16(body + 14);
+            if ((format != 1 && format != 0xFFFE) || bits != 16 || fmt.channels < 1 || fmt.channels > 2 || fmt.rate <= 0)
+                return false;
+            haveFormat = true;
+            if (fseek(f, (long)(size - 16 + (size & 1)), SEEK_CUR)) return false;
+        }
+        else if (!memcmp(chunk, "data", 4)) {
+            if (!haveFormat) return false;
+            fmt.dataStart = ftell(f);
+            fmt.dataBytes = size;
+            return true;
+        }
+        else if (fseek(f, (long)(size + (size & 1)), SEEK_CUR)) return false;
+    }
+    return false;
+}
+
+int16_t clamp16(int32_t v) {
+    return (int16_t)(v < -32768 ? -32768 : v > 32767 ? 32767 : v);
+}
+
+}
+
+bool loadWav(const std::string& path, SoundClip& out) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    WavFormat fmt;
+    bool ok = readWavHeader(f, fmt);
+    std::vector<int16_t> raw;
+    if (ok) {
+        raw.resize(fmt.dataBytes / 2);
+        raw.resize(fread(raw.data(), 2, raw.size(), f));
+    }
+    fclose(f);
+    if (!ok) return false;
+
+    size_t frames = raw.size() / fmt.channels;
+    size_t length = (size_t)((double)frames * AUDIO_RATE / fmt.rate);
+    out.samples.resize(length);
+    double step = (double)fmt.rate / AUDIO_RATE;
+    for (size_t i = 0; i < length; ++i) {
+        double at = i * step;
+        size_t a = (size_t)at;
+        size_t b = std::min(a + 1, frames - 1);
+        float t = (float)(at - a);
+        float sa = 0.f, sb = 0.f;
+        for (int c = 0; c < fmt.channels; ++c) {
+            sa += raw[a * fmt.channels + c];
+            sb += raw[b * fmt.channels + c];
+        }
+        out.samples[i] = clamp16((int32_t)((sa + (sb - sa) * t) / fmt.channels));
+    }
+    return true;
+}
+
+void synthesizeSfx(Sfx which, SoundClip& out) {
+    // A fixed-seed noise source keeps the effects identical from run to run.
+    uint32_t seed = 0x9e3779b9u;
+    auto noise = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return (float)(int32_t)seed / 2147483648.f;
+    };
+    const float pi = 3.14159265f;
+    float seconds = which == Sfx::PUNCH ? 0.12f : which == Sfx::KO ? 0.6f : 0.15f;
+    size_t n = (size_t)(seconds * AUDIO_RATE);
+    out.samples.resize(n);
+    float phase = 0.f, low = 0.f;
+    for (size_t i = 0; i < n; ++i) {
+        float t = (float)i / AUDIO_RATE;
+        float s = 0.f;
+        if (which == Sfx::PUNCH) {
+            // A thump falling from 180 to 60 Hz under a burst of filtered noise.
+            phase += 2.f * pi * (60.f + 120.f * std::exp(-t * 40.f)) / AUDIO_RATE;
+            low += (noise() - low) * 0.3f;
+            s = std::sin(phase) * std::exp(-t * 30.f) + low * std::exp(-t * 60.f) * 1.5f;
+        }
+        else if (which == Sfx::KO) {
+            // A long low boom with a falling tone on top.
+            phase += 2.f * pi * (45.f + 200.f * std::exp(-t * 6.f)) / AUDIO_RATE;
+            low += (noise() - low) * 0.05f;
+            s = std::sin(phase) * std::exp(-t * 5.f) + low * std::exp(-t * 8.f) * 2.f;
+        }
+        else {
+            // A short rising chirp.
+            phase += 2.f * pi * (300.f + 900.f * t / seconds) / AUDIO_RATE;
+            s = std::sin(phase) * std::sin(pi * t / seconds) * 0.5f;
+        }
+        out.samples[i] = clamp16((int32_t)(s * 0.6f * 32767.f));
+    }
+}
+
+bool MusicStream::open(const std::string& path, bool loop) {
+    close();
+    file = fopen(path.c_str(), "rb");
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    WavFormat fmt;
+    if (!readWavHeader(file, fmt) || fmt.rate != AUDIO_RATE) {
+        error = path + ": not a 16-bit 44.1 kHz PCM WAV file";
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+    channels = fmt.channels;
+    dataStart = fmt.dataStart;
+    dataBytes = fmt.dataBytes;
+    dataRead = 0;
+    looping = loop;
+    readPos.store(0);
+    writePos.store(0);
+    quit.store(false);
+    ended.store(false);
+    underruns.store(0);
+    error.clear();
+    // The first block is mixed as soon as active is set, before the thread
+    // would have read anything.
+    fill();
+    thread = std::thread(&MusicStream::loop, this);
+    active.store(true);
+    return true;
+}
+
+void MusicStream::close() {
+    active.store(false);
+    while (mixing.load()) std::this_thread::yield();
+    if (thread.joinable()) {
+        quit.store(true);
+        thread.join();
+    }
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+size_t MusicStream::readFrames(size_t frames) {
+    uint32_t frameBytes = 2 * channels;
+    if (dataRead + frameBytes > dataBytes) {
+        if (!looping || fseek(file, dataStart, SEEK_SET)) return 0;
+        dataRead = 0;
+    }
+    frames = std::min(frames, (size_t)((dataBytes - dataRead) / frameBytes));
+    size_t got = fread(chunk.data(), frameBytes, frames, file);
+    dataRead += (uint32_t)(got * frameBytes);
+    if (got < frames) dataRead = dataBytes;   // short file: treat as its end
+    if (channels == 1) {
+        for (size_t i = got; i-- > 0;) {
+            chunk[i * 2] = chunk[i];
+            chunk[i * 2 + 1] = chunk[i];
+        }
+    }
+    return got;
+}
+
+void MusicStream::loop() {
+    while (!quit.load()) {
+        uint64_t w = writePos.load(std::memory_order_relaxed);
+        size_t space = RING_FRAMES - (size_t)(w - readPos.load(std::memory_order_acquire));
+        if (space < CHUNK_FRAMES) {
+            // The ring holds several blocks' worth; topping it up every few ms is plenty.
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            continue;
+        }
+        if (!fill()) {
+            if (w == readPos.load(std::memory_order_acquire)) ended.store(true);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+}
+
+size_t MusicStream::fill() {
+    uint64_t w = writePos.load(std::memory_order_relaxed);
+    size_t got = readFrames(CHUNK_FRAMES);
+    for (size_t i = 0; i < got; ++i) {
+        size_t at = (size_t)((w + i) % RING_FRAMES) * 2;
+        ring[at] = chunk[i * 2];
+        ring[at + 1] = chunk[i * 2 + 1];
+    }
+    writePos.store(w + got, std::memory_order_release);
+    return got;
+}
+
+void MusicStream::mixInto(int32_t* mix, int frames, int32_t gain) {
+    mixing.store(true);
+    if (!active.load() || ended.load(std::memory_order_relaxed)) {
+        mixing.store(false);
+        return;
+    }
+    uint64_t r = readPos.load(std::memory_order_relaxed);
+    size_t avail = (size_t)(writePos.load(std::memory_order_acquire) - r);
+    size_t n = std::min(avail, (size_t)frames);
+    if (n < (size_t)frames) underruns.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < n; ++i) {
+        size_t at = (size_t)((r + i) % RING_FRAMES) * 2;
+        mix[i * 2] += (ring[at] * gain) >> 15;
+        mix[i * 2 + 1] += (ring[at + 1] * gain) >> 15;
+    }
+    readPos.store(r + n, std::memory_order_release);
+    mixing.store(false);
+}
+
+AudioMixer::AudioMixer() {
+    for (int s = 0; s < (int)Sfx::COUNT; ++s) synthesizeSfx((Sfx)s, clips[s]);
+}
+
+void AudioMixer::play(Sfx which, float volume) {
+    uint32_t head = triggerHead.load(std::memory_order_relaxed);
+    if (head - triggerTail.load(std::memory_order_acquire) >= (uint32_t)MAX_TRIGGERS) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Trigger& t = triggers[head % MAX_TRIGGERS];
+    t.sfx = which;
+    t.gain = (int32_t)(std::min(std::max(volume, 0.f), 1.f) * 32768.f);
+    t.timeNs = nowNs();
+    triggerHead.store(head + 1, std::memory_order_release);
+}
+
+void AudioMixer::start(const Trigger& t) {
+    const SoundClip& clip = clips[(int)t.sfx];
+    if (clip.samples.empty()) return;
+    Voice* v = nullptr;
+    for (Voice& c : voices) {
+        if (!c.samples) {
+            v = &c;
+            break;
+        }
+        if (!v || c.length - c.pos < v->length - v->pos) v = &c;
+    }
+    if (v->samples) dropped.fetch_add(1, std::memory_order_relaxed);
+    v->samples = clip.samples.data();
+    v->length = (uint32_t)clip.samples.size();
+    v->pos = 0;
+    v->gain = t.gain;
+
+    int64_t waited = nowNs() - t.timeNs;
+    if (waited > maxLatencyNs.load(std::memory_order_relaxed)) maxLatencyNs.store(waited, std::memory_order_relaxed);
+}
+
+void AudioMixer::mixBlock(int16_t* out, int frames) {
+    uint32_t tail = triggerTail.load(std::memory_order_relaxed);
+    uint32_t head = triggerHead.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) start(triggers[tail % MAX_TRIGGERS]);
+    triggerTail.store(tail, std::memory_order_release);
+
+    memset(accum, 0, sizeof(int32_t) * frames * 2);
+    music.mixInto(accum, frames, musicGain.load(std::memory_order_relaxed));
+    for (Voice& v : voices) {
+        if (!v.samples) continue;
+        int n = (int)std::min<uint32_t>(frames, v.length - v.pos);
+        const int16_t* src = v.samples + v.pos;
+        for (int i = 0; i < n; ++i) {
+            int32_t s = (src[i] * v.gain) >> 15;
+            accum[i * 2] += s;
+            accum[i * 2 + 1] += s;
+        }
+        v.pos += n;
+        if (v.pos >= v.length) v.samples = nullptr;
+    }
+    for (int i = 0; i < frames * 2; ++i) out[i] = clamp16(accum[i]);
+}
+
+void AudioMixer::mix(int16_t* out, int frames) {
+    while (frames > 0) {
+        int n = std::min(frames, AUDIO_BLOCK);
+        mixBlock(out, n);
+        out += n * 2;
+        frames -= n;
+    }
+}
+
+int AudioMixer::getActiveVoices() const {
+    int n = 0;
+    for (const Voice& v : voices)
+        if (v.samples) ++n;
+    return n;
+}
+
+bool NullAudioSink::start(AudioMixer& m) {
+    stop();
+    mixer = &m;
+    quit.store(false);
+    thread = std::thread(&NullAudioSink::loop, this);
+    return true;
+}
+
+void NullAudioSink::stop() {
+    if (thread.joinable()) {
+        quit.store(true);
+        thread.join();
+    }
+}
+
+void NullAudioSink::loop() {
+    int16_t block[AUDIO_BLOCK * 2];
+    auto period = std::chrono::nanoseconds((int64_t)AUDIO_BLOCK * 1000000000 / AUDIO_RATE);
+    auto next = std::chrono::steady_clock::now();
+    while (!quit.load()) {
+        mixer->mix(block, AUDIO_BLOCK);
+        int level = peak.load(std::memory_order_relaxed);
+        for (int16_t s : block) level = std::max(level, std::abs((int)s));
+        peak.store(level, std::memory_order_relaxed);
+        frames.fetch_add(AUDIO_BLOCK, std::memory_order_relaxed);
+        next += period;
+        std::this_thread::sleep_until(next);
+    }
+}
+
+#ifdef _WIN32
+
+// waveOut with a few small buffers refilled as the device returns them.
+class WaveOutSink : public AudioSink {
+private:
+    static const int BUFFERS = 3;
+    AudioMixer* mixer = nullptr;
+    HWAVEOUT device = nullptr;
+    HANDLE done = nullptr;
+    WAVEHDR headers[BUFFERS];
+    int16_t blocks[BUFFERS][AUDIO_BLOCK * 2];
+    std::thread thread;
+    std::atomic<bool> quit{ false };
+
+    void loop() {
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+        while (!quit.load()) {
+            WaitForSingleObject(done, 20);
+            for (WAVEHDR& h : headers) {
+                if (!(h.dwFlags & WHDR_DONE)) continue;
+                mixer->mix((int16_t*)h.lpData, AUDIO_BLOCK);
+                waveOutWrite(device, &h, sizeof(WAVEHDR));
+            }
+        }
+    }
+public:
+    ~WaveOutSink() { stop(); }
+
+    bool start(AudioMixer& m) override {
+        stop();
+        mixer = &m;
+        WAVEFORMATEX fmt = {};
+        fmt.wFormatTag = WAVE_FORMAT_PCM;
+        fmt.nChannels = 2;
+        fmt.nSamplesPerSec = AUDIO_RATE;
+        fmt.wBitsPerSample = 16;
+        fmt.nBlockAlign = 4;
+        fmt.nAvgBytesPerSec = AUDIO_RATE * 4;
+        done = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+        if (waveOutOpen(&device, WAVE_MAPPER, &fmt, (DWORD_PTR)done, 0, CALLBACK_EVENT) != MMSYSERR_NOERROR) {
+            CloseHandle(done);
+            done = nullptr;
+            device = nullptr;
+            return false;
+        }
+        for (int i = 0; i < BUFFERS; ++i) {
+            WAVEHDR& h = headers[i];
+            memset(&h, 0, sizeof(h));
+            h.lpData = (LPSTR)blocks[i];
+            h.dwBufferLength = sizeof(blocks[i]);
+            waveOutPrepareHeader(device, &h, sizeof(WAVEHDR));
+            mixer->mix(blocks[i], AUDIO_BLOCK);
+            waveOutWrite(device, &h, sizeof(WAVEHDR));
+        }
+        quit.store(false);
+        thread = std::thread(&WaveOutSink::loop, this);
+        return true;
+    }
+
+    void stop() override {
+        if (thread.joinable()) {
+            quit.store(true);
+            thread.join();
+        }
+        if (device) {
+            waveOutReset(device);
+            for (WAVEHDR& h : headers) waveOutUnprepareHeader(device, &h, sizeof(WAVEHDR));
+            waveOutClose(device);
+            device = nullptr;
+        }
+        if (done) {
+            CloseHandle(done);
+            done = nullptr;
+        }
+    }
+
+    double getQueuedMs() const override { return BUFFERS * AUDIO_BLOCK * 1000.0 / AUDIO_RATE; }
+};
+
+#endif
+
+AudioSink* createAudioSink() {
+#ifdef _WIN32
+    return new WaveOutSink();
+#else
+    return new NullAudioSink();
+#endif
+}
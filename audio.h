@@ -0,0 +1,156 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Sound effects and streamed music mixed by our own code, next to SGG's
+// music playback. Samples are 16-bit at 44.1 kHz everywhere: effects are
+// mono, the music and the mix stereo.
+//
+// The game thread only ever calls AudioMixer::play(), which puts a trigger
+// on a lock-free queue; the sink's thread picks it up at the start of the
+// next mixed block, so an effect starts at most one block (2.9 ms) after the
+// tick that caused it, plus whatever the sink has queued for the device.
+// Music is read from disk on its own thread into a fixed ring buffer, so it
+// takes the same memory however long the track is.
+
+const int AUDIO_RATE = 44100;
+const int AUDIO_BLOCK = 128;   // frames per mixed block
+
+enum class Sfx : uint8_t { PUNCH, KO, JUMP, COUNT };
+
+struct SoundClip {
+    std::vector<int16_t> samples;   // mono, AUDIO_RATE
+};
+
+// PCM 16-bit WAV, mono or stereo at any rate, mixed down and resampled.
+bool loadWav(const std::string& path, SoundClip& out);
+// Short built-in effects for when there are no files for them.
+void synthesizeSfx(Sfx which, SoundClip& out);
+
+// Streams a 16-bit 44.1 kHz WAV file through a ring buffer filled by its
+// own thread; the audio thread only reads from the ring.
+class MusicStream {
+public:
+    static const size_t RING_FRAMES = 32768;   // 0.74 s
+    static const size_t CHUNK_FRAMES = 4096;
+private:
+    FILE* file = nullptr;
+    long dataStart = 0;
+    uint32_t dataBytes = 0, dataRead = 0;
+    int channels = 2;
+    bool looping = false;
+    std::vector<int16_t> ring, chunk;
+    std::atomic<uint64_t> readPos{ 0 }, writePos{ 0 };
+    std::atomic<bool> quit{ false }, ended{ false };
+    // active is set once the reader thread runs and cleared before it is
+    // joined; the audio thread only touches the stream between the two, and
+    // raises mixing while it does so close() can wait it out.
+    std::atomic<bool> active{ false }, mixing{ false };
+    std::atomic<uint32_t> underruns{ 0 };
+    std::thread thread;
+    std::string error;
+
+    void loop();
+    // Reads up to frames from the file as stereo into chunk; 0 at the end.
+    size_t readFrames(size_t frames);
+    // Reads a chunk and appends it to the ring, which must have room for it.
+    size_t fill();
+public:
+    MusicStream() : ring(RING_FRAMES * 2), chunk(CHUNK_FRAMES * 2) {}
+    ~MusicStream() { close(); }
+    bool open(const std::string& path, bool loop);
+    void close();
+    bool isPlaying() const { return active.load() && !ended.load(); }
+
+    // Audio thread: adds up to frames of music times gain (Q15) to mix.
+    void mixInto(int32_t* mix, int frames, int32_t gain);
+    uint32_t getUnderruns() const { return underruns.load(); }
+    // Everything the stream holds, fixed at construction.
+    size_t getMemoryBytes() const { return (ring.size() + chunk.size()) * sizeof(int16_t); }
+    const std::string& getError() const { return error; }
+};
+
+class AudioMixer {
+public:
+    static const int MAX_VOICES = 16;
+    static const int MAX_TRIGGERS = 64;
+private:
+    struct Voice {
+        const int16_t* samples = nullptr;   // null when free
+        uint32_t length = 0, pos = 0;
+        int32_t gain = 0;                   // Q15
+    };
+    struct Trigger {
+        Sfx sfx;
+        int32_t gain;
+        int64_t timeNs;
+    };
+    SoundClip clips[(int)Sfx::COUNT];
+    Voice voices[MAX_VOICES];
+    // Single producer (the game thread), single consumer (the audio thread).
+    Trigger triggers[MAX_TRIGGERS];
+    std::atomic<uint32_t> triggerHead{ 0 }, triggerTail{ 0 };
+    int32_t accum[AUDIO_BLOCK * 2];
+    MusicStream music;
+    std::atomic<int32_t> musicGain{ 1 << 15 };
+    std::atomic<int64_t> maxLatencyNs{ 0 };
+    std::atomic<uint32_t> dropped{ 0 };
+
+    void start(const Trigger& t);
+    void mixBlock(int16_t* out, int frames);
+public:
+    AudioMixer();
+    void setClip(Sfx which, const SoundClip& clip) { clips[(int)which] = clip; }
+
+    // Game thread. Never blocks or allocates; when all voices are busy the
+    // one closest to its end is cut.
+    void play(Sfx which, float volume = 1.f);
+    MusicStream& getMusic() { return music; }
+    void setMusicVolume(float volume) { musicGain.store((int32_t)(volume * 32768.f)); }
+
+    // Audio thread: renders frames of interleaved stereo.
+    void mix(int16_t* out, int frames);
+
+    // Longest wait from play() to the block the effect starts in.
+    double getMaxLatencyMs() const { return maxLatencyNs.load() / 1e6; }
+    uint32_t getDropped() const { return dropped.load(); }
+    int getActiveVoices() const;
+};
+
+// Pulls blocks from a mixer on its own thread and sends them to a device.
+class AudioSink {
+public:
+    virtual ~AudioSink() {}
+    virtual bool start(AudioMixer& mixer) = 0;
+    virtual void stop() = 0;
+    // Audio queued ahead of the speakers.
+    virtual double getQueuedMs() const = 0;
+};
+
+// Mixes at the real-time rate and throws the result away, keeping only the
+// peak level and a frame count: for headless runs and machines without a
+// sound device.
+class NullAudioSink : public AudioSink {
+private:
+    AudioMixer* mixer = nullptr;
+    std::thread thread;
+    std::atomic<bool> quit{ false };
+    std::atomic<uint64_t> frames{ 0 };
+    std::atomic<int> peak{ 0 };
+
+    void loop();
+public:
+    ~NullAudioSink() { stop(); }
+    bool start(AudioMixer& m) override;
+    void stop() override;
+    double getQueuedMs() const override { return 0.0; }
+    uint64_t getFrames() const { return frames.load(); }
+    int getPeak() const { return peak.load(); }
+};
+
+// The platform's device sink (waveOut on Windows), or a NullAudioSink.
+AudioSink* createAudioSink();
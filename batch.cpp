@@ -0,0 +1,173 @@
+#include "batch.h"
+#include "bot.h"
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+void BatchStats::merge(const BatchStats& other) {
+    matches += other.matches;
+    ticks += other.ticks;
+    for (int s = 0; s < 2; ++s) {
+        wins[s] += other.wins[s];
+        damage[s] += other.damage[s];
+    }
+    draws += other.draws;
+    timeouts += other.timeouts;
+    steals += other.steals;
+    if (koTicks.size() < other.koTicks.size()) koTicks.resize(other.koTicks.size(), 0);
+    for (size_t t = 0; t < other.koTicks.size(); ++t) koTicks[t] += other.koTicks[t];
+}
+
+long long BatchStats::getKoCount() const {
+    long long n = 0;
+    for (uint32_t c : koTicks) n += c;
+    return n;
+}
+
+double BatchStats::getMeanKoSeconds() const {
+    long long n = 0;
+    double sum = 0.0;
+    for (size_t t = 0; t < koTicks.size(); ++t) {
+        n += koTicks[t];
+        sum += (double)t * koTicks[t];
+    }
+    return n ? sum / n * SIM_DT : 0.0;
+}
+
+double BatchStats::getKoPercentileSeconds(double fraction) const {
+    long long n = getKoCount();
+    if (n == 0) return 0.0;
+    long long rank = std::min(n - 1, (long long)(n * fraction));
+    long long seen = 0;
+    for (size_t t = 0; t < koTicks.size(); ++t) {
+        seen += koTicks[t];
+        if (seen > rank) return t * SIM_DT;
+    }
+    return (koTicks.size() - 1) * SIM_DT;
+}
+
+void TaskQueue::push(uint32_t task) {
+    std::lock_guard<std::mutex> guard(lock);
+    tasks.push_back(task);
+}
+
+bool TaskQueue::pop(uint32_t& task) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (tasks.empty()) return false;
+    task = tasks.back();
+    tasks.pop_back();
+    return true;
+}
+
+bool TaskQueue::steal(uint32_t& task) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (tasks.empty()) return false;
+    task = tasks.front();
+    tasks.pop_front();
+    return true;
+}
+
+namespace {
+
+// Per-thread arena: the Simulation and scratch buffers are reset between
+// tasks but keep their capacity, so steady state does no allocation.
+struct Worker {
+    Simulation sim;
+    std::vector<uint8_t> buttons, ended;
+    BatchStats stats;
+};
+
+void runTask(Worker& w, const BatchConfig& config, uint32_t task) {
+    long long first = (long long)task * config.duelsPerTask;
+    int count = (int)std::min<long long>(config.duelsPerTask, config.matches - first);
+    Rng rng(config.seed + task * 0x9E3779B9u);
+
+    Simulation& sim = w.sim;
+    sim.reset(count);
+    FighterStore& f = sim.getFighters();
+    w.buttons.assign(f.size(), 0);
+    w.ended.assign((size_t)count, 0);
+
+    int running = count, tick = 0;
+    while (running > 0 && tick < config.maxTicks) {
+        for (int d = 0; d < count; ++d) {
+            if (w.ended[d]) continue;
+            FighterHandle p1 = (FighterHandle)d * 2, p2 = p1 + 1;
+            w.buttons[p1] = botInput(f, p1, p2, rng);
+            w.buttons[p2] = botInput(f, p2, p1, rng);
+        }
+        sim.update(w.buttons.data(), SIM_DT);
+        w.stats.ticks += running;
+        ++tick;
+        for (int d = 0; d < count; ++d) {
+            if (w.ended[d] || !sim.isOver(d)) continue;
+            w.ended[d] = 1;
+            w.buttons[d * 2] = w.buttons[d * 2 + 1] = 0;
+            ++w.stats.koTicks[tick];
+            --running;
+        }
+    }
+
+    BatchStats& s = w.stats;
+    s.matches += count;
+    s.timeouts += running;
+    for (int d = 0; d < count; ++d) {
+        int winner = sim.getWinner(d);
+        if (winner < 0) ++s.draws;
+        else ++s.wins[winner];
+        s.damage[0] += toFloat(100.f - f.health[d * 2 + 1]);
+        s.damage[1] += toFloat(100.f - f.health[d * 2]);
+    }
+}
+
+void workerLoop(std::vector<std::unique_ptr<TaskQueue>>& queues, size_t self, Worker& w, const BatchConfig& config) {
+    w.sim.setParams(config.params);
+    w.sim.setMoves(config.moves);
+    w.stats.koTicks.assign((size_t)config.maxTicks + 1, 0);
+    size_t n = queues.size();
+    uint32_t task;
+    for (;;) {
+        if (queues[self]->pop(task)) {
+            runTask(w, config, task);
+            continue;
+        }
+        // No task creates more work, so once every queue is empty the batch is done.
+        bool found = false;
+        for (size_t i = 1; i < n && !found; ++i)
+            found = queues[(self + i) % n]->steal(task);
+        if (!found) return;
+        ++w.stats.steals;
+        runTask(w, config, task);
+    }
+}
+
+}
+
+BatchStats runBatch(const BatchConfig& config) {
+    int threads = config.threads;
+    if (threads <= 0) {
+        threads = (int)std::thread::hardware_concurrency();
+        if (threads < 1) threads = 1;
+    }
+    long long taskCount = config.matches > 0 ? (config.matches + config.duelsPerTask - 1) / config.duelsPerTask : 0;
+    if (threads > taskCount) threads = taskCount > 0 ? (int)taskCount : 1;
+
+    // Contiguous blocks per worker; stealing evens out whatever imbalance is left.
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    for (int i = 0; i < threads; ++i) queues.emplace_back(new TaskQueue());
+    for (int i = 0; i < threads; ++i) {
+        long long begin = taskCount * i / threads, end = taskCount * (i + 1) / threads;
+        for (long long t = end - 1; t >= begin; --t) queues[i]->push((uint32_t)t);
+    }
+
+    std::vector<Worker> workers((size_t)threads);
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i)
+        pool.emplace_back(workerLoop, std::ref(queues), (size_t)i, std::ref(workers[i]), std::cref(config));
+    workerLoop(queues, 0, workers[0], config);
+    for (std::thread& t : pool) t.join();
+
+    BatchStats total;
+    for (const Worker& w : workers) total.merge(w.stats);
+    return total;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "sim.h"
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Runs large numbers of headless bot matches across all cores for balance
+// testing. Matches are split into tasks of duelsPerTask duels that share one
+// Simulation; each worker owns a deque of tasks and steals from the others
+// when it runs dry. Every task seeds its own Rng from its index, so the
+// results do not depend on the thread count or on which worker ran what.
+
+struct BatchConfig {
+    FightParams params;
+    const MoveTable* moves = nullptr;  // nullptr uses defaultMoves()
+    long long matches = 100000;
+    uint32_t seed = 1;
+    int threads = 0;            // <= 0 uses every core
+    int duelsPerTask = 64;
+    int maxTicks = SIM_HZ * 99; // matches still running after this are draws
+};
+
+struct BatchStats {
+    long long matches = 0;
+    long long ticks = 0;               // duel-ticks: one per unfinished match per update
+    long long wins[2] = { 0, 0 }, draws = 0, timeouts = 0;
+    double damage[2] = { 0.0, 0.0 };  // total damage dealt by each side
+    std::vector<uint32_t> koTicks;     // histogram of the tick each KO happened on
+    long long steals = 0;
+
+    void merge(const BatchStats& other);
+    long long getKoCount() const;
+    double getMeanKoSeconds() const;
+    double getKoPercentileSeconds(double fraction) const;
+};
+
+// A worker's task list. The owner takes from the back, thieves from the front,
+// so a steal takes the work the owner would have reached last.
+class TaskQueue {
+private:
+    std::mutex lock;
+    std::deque<uint32_t> tasks;
+public:
+    void push(uint32_t task);
+    bool pop(uint32_t& task);
+    bool steal(uint32_t& task);
+};
+
+BatchStats runBatch(const BatchConfig& config);
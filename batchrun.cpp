@@ -0,0 +1,101 @@
+#include "batch.h"
+#include "moves.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+// Balance-testing driver for runBatch.
+//   batchrun [matches] [seed] [threads] [name=value ...] [--moves file] [--scale]
+// Tunable names: speed, and for the punch: damage, reach, startup, active,
+// recovery, knockback (frames are 120 Hz ticks). --moves starts from a move file.
+// --scale repeats the batch at 1, 2, 4, ... threads and reports the speedup.
+
+static bool setParam(FightParams& p, MoveDef& punch, const char* arg) {
+    const char* eq = strchr(arg, '=');
+    if (!eq) return false;
+    std::string name(arg, eq - arg);
+    float value = (float)atof(eq + 1);
+    if (name == "speed") p.speed = value;
+    else if (name == "damage") punch.damage = value;
+    else if (name == "reach") { punch.hitLeft = -value; punch.hitRight = value; }
+    else if (name == "startup") punch.startup = (int)value;
+    else if (name == "active") punch.active = (int)value;
+    else if (name == "recovery") punch.recovery = (int)value;
+    else if (name == "knockback") punch.knockback = value;
+    else return false;
+    return true;
+}
+
+static double timedRun(const BatchConfig& config, BatchStats& stats) {
+    auto start = std::chrono::steady_clock::now();
+    stats = runBatch(config);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void printStats(const BatchStats& s) {
+    double n = s.matches ? (double)s.matches : 1.0;
+    printf("matches: %lld  p1 wins: %lld (%.1f%%)  p2 wins: %lld (%.1f%%)  draws: %lld  timeouts: %lld\n",
+        s.matches, s.wins[0], 100.0 * s.wins[0] / n, s.wins[1], 100.0 * s.wins[1] / n, s.draws, s.timeouts);
+    printf("damage dealt per match: p1 %.1f  p2 %.1f\n", s.damage[0] / n, s.damage[1] / n);
+    printf("time to KO: mean %.2f s  p50 %.2f s  p99 %.2f s\n",
+        s.getMeanKoSeconds(), s.getKoPercentileSeconds(0.5), s.getKoPercentileSeconds(0.99));
+}
+
+int main(int argc, char** argv) {
+    BatchConfig config;
+    MoveTable moves;
+    for (int i = 1; i + 1 < argc; ++i)
+        if (strcmp(argv[i], "--moves") == 0 && !moves.load(argv[i + 1])) { printf("%s\n", moves.getError().c_str()); return 1; }
+    std::vector<MoveDef> defs = moves.getDefs();
+    MoveId punch = moves.forInput(INPUT_PUNCH);
+    if (punch == MOVE_NONE) { printf("no move is bound to punch\n"); return 1; }
+    MoveDef& def = defs[punch];
+
+    bool scale = false;
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--scale") == 0) scale = true;
+        else if (strcmp(argv[i], "--moves") == 0) ++i;
+        else if (strchr(argv[i], '=')) {
+            if (!setParam(config.params, def, argv[i])) { printf("unknown parameter %s\n", argv[i]); return 1; }
+        }
+        else if (positional == 0) { config.matches = atoll(argv[i]); ++positional; }
+        else if (positional == 1) { config.seed = (uint32_t)strtoul(argv[i], nullptr, 10); ++positional; }
+        else if (positional == 2) { config.threads = atoi(argv[i]); ++positional; }
+    }
+    int cores = (int)std::thread::hardware_concurrency();
+    if (cores < 1) cores = 1;
+
+    moves.setDefs(defs);
+    config.moves = &moves;
+    printf("speed %.1f  %s: damage %.1f  reach %.1f..%.1f  frames %d/%d/%d  knockback %.1f\n",
+        config.params.speed, def.name.c_str(), def.damage, def.hitLeft, def.hitRight,
+        def.startup, def.active, def.recovery, def.knockback);
+
+    BatchStats stats;
+    if (!scale) {
+        double secs = timedRun(config, stats);
+        printStats(stats);
+        printf("threads: %d  steals: %lld  time: %.3f s  matches/s: %.0f  ticks/s: %.0f\n",
+            config.threads > 0 ? config.threads : cores, stats.steals, secs, stats.matches / secs, stats.ticks / secs);
+        return 0;
+    }
+
+    double baseline = 0.0;
+    int maxThreads = config.threads > 0 ? config.threads : cores;
+    for (int t = 1; ; t = t * 2 < maxThreads ? t * 2 : maxThreads) {
+        config.threads = t;
+        double secs = timedRun(config, stats);
+        if (t == 1) {
+            printStats(stats);
+            baseline = secs;
+        }
+        printf("threads: %2d  time: %.3f s  matches/s: %.0f  speedup: %.2fx  steals: %lld\n",
+            t, secs, stats.matches / secs, baseline / secs, stats.steals);
+        if (t == maxThreads) break;
+    }
+    return 0;
+}
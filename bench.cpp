@@ -0,0 +1,423 @@
+#include "alloccheck.h"
+#include "anim.h"
+#include "audio.h"
+#include "bot.h"
+#include "collision.h"
+#include "crowd.h"
+#include "moves.h"
+#include "particles.h"
+#include "png.h"
+#include "raster.h"
+#include "spritebatch.h"
+#include "statehash.h"
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+// Microbenchmarks for the fight simulation, built on Google Benchmark.
+// Inputs are pre-generated so only the simulation is measured.
+//   g++ -std=c++17 -O2 -Iinclude -DKOMBAT_ALLOC_CHECK sim.cpp moves.cpp collision.cpp crowd.cpp
+//       spritebatch.cpp particles.cpp anim.cpp assets.cpp pack.cpp png.cpp raster.cpp audio.cpp
+//       statehash.cpp alloccheck.cpp bench.cpp -o bench -lbenchmark -pthread
+//   ./bench --benchmark_format=json --benchmark_out=bench.json
+
+// Bot inputs recorded from a real match, repeated to the requested length.
+static std::vector<uint8_t> scriptedInputs(size_t fighters, size_t ticks) {
+    std::vector<uint8_t> inputs(fighters * ticks);
+    Rng rng(7);
+    Simulation sim;
+    for (size_t t = 0; t < ticks; ++t) {
+        if (sim.isOver()) sim.reset();
+        uint8_t pair[2] = { botInput(sim.getFighters(), 0, 1, rng), botInput(sim.getFighters(), 1, 0, rng) };
+        sim.update(pair, SIM_DT);
+        for (size_t f = 0; f < fighters; ++f) inputs[t * fighters + f] = pair[f & 1];
+    }
+    return inputs;
+}
+
+// Spreads duels over the arena and staggers them so they are not all in lockstep.
+static void spawnCrowd(Simulation& sim, int duels) {
+    sim.reset(duels);
+    FighterStore& f = sim.getFighters();
+    for (size_t i = 0; i < f.size(); ++i) {
+        f.x[i] = 50.f + (float)((i * 37) % 700);
+        f.moveFrame[i] = (uint16_t)(i % 5 ? defaultMoves().getFirstFrame(0) + i % 60 : 0);
+    }
+}
+
+static void BM_UpdateFighters(benchmark::State& state) {
+    int duels = (int)state.range(0);
+    const size_t ticks = 512;
+    Simulation sim;
+    spawnCrowd(sim, duels);
+    FighterStore& f = sim.getFighters();
+    std::vector<uint8_t> inputs = scriptedInputs(f.size(), ticks);
+    size_t t = 0;
+    for (auto _ : state) {
+        updateFighters(f, &inputs[(t++ % ticks) * f.size()], SIM_DT, defaultMoves());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)f.size());
+}
+BENCHMARK(BM_UpdateFighters)->RangeMultiplier(8)->Range(1, 4096);
+
+static void BM_CheckHit(benchmark::State& state) {
+    Simulation sim;
+    FighterStore& f = sim.getFighters();
+    f.x[0] = 300.f;
+    f.x[1] = 340.f;
+    f.anim[0] = AnimState::PUNCHING;
+    f.moveFrame[0] = sim.getMoves().getFirstFrame(0);
+    for (auto _ : state) {
+        f.health[1] = 100.f;
+        checkHit(f, 0, 1, sim.getMoves());
+        benchmark::DoNotOptimize(f.health[1]);
+    }
+}
+BENCHMARK(BM_CheckHit);
+
+static void BM_ResolveOverlap(benchmark::State& state) {
+    Simulation sim;
+    FighterStore& f = sim.getFighters();
+    for (auto _ : state) {
+        f.x[0] = 330.f;
+        f.x[1] = 310.f;
+        resolveOverlap(f, 0, 1);
+        benchmark::DoNotOptimize(f.x[0]);
+    }
+}
+BENCHMARK(BM_ResolveOverlap);
+
+// Tags the sim benchmarks with the build's Scalar, so float and fixed-point
+// (-DKOMBAT_FIXED_POINT) runs can be told apart when compared.
+#ifdef KOMBAT_FIXED_POINT
+static const char* const SCALAR_LABEL = "fixed";
+#else
+static const char* const SCALAR_LABEL = "float";
+#endif
+
+// One full Simulation::update over a crowd of independent duels.
+static void BM_Tick(benchmark::State& state) {
+    int duels = (int)state.range(0);
+    const size_t ticks = 512;
+    Simulation sim;
+    spawnCrowd(sim, duels);
+    size_t n = sim.getFighters().size();
+    std::vector<uint8_t> inputs = scriptedInputs(n, ticks);
+    size_t t = 0;
+    for (auto _ : state) {
+        sim.update(&inputs[(t++ % ticks) * n], SIM_DT);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)n);
+    state.counters["ticks/s"] = benchmark::Counter((double)state.iterations(), benchmark::Counter::kIsRate);
+    state.SetLabel(SCALAR_LABEL);
+}
+BENCHMARK(BM_Tick)->RangeMultiplier(8)->Range(1, 2048);
+
+// A two-player match of a fixed length from reset, restarting on KO.
+static void BM_Match(benchmark::State& state) {
+    size_t ticks = (size_t)state.range(0);
+    std::vector<uint8_t> inputs = scriptedInputs(2, ticks);
+    Simulation sim;
+    for (auto _ : state) {
+        sim.reset();
+        for (size_t t = 0; t < ticks; ++t) {
+            if (sim.isOver()) sim.reset();
+            sim.update(&inputs[t * 2], SIM_DT);
+        }
+        benchmark::DoNotOptimize(sim.getFighters().health[0]);
+    }
+    state.counters["ticks/s"] = benchmark::Counter((double)(state.iterations() * ticks), benchmark::Counter::kIsRate);
+    state.SetLabel(SCALAR_LABEL);
+}
+BENCHMARK(BM_Match)->Arg(SIM_HZ * 10)->Arg(SIM_HZ * 60)->Arg(SIM_HZ * 99);
+
+// Crowd mode: everyone on one line, random inputs. The budget is 1 ms per tick.
+static void BM_Crowd(benchmark::State& state) {
+    int count = (int)state.range(0);
+    const size_t ticks = 256;
+    std::vector<uint8_t> inputs((size_t)count * ticks);
+    Rng rng(11);
+    for (uint8_t& b : inputs) b = (uint8_t)(rng.next() & 15);
+    MoveTable moves;
+    std::vector<MoveDef> defs = moves.getDefs();
+    defs[0].damage = 0.f;
+    moves.setDefs(defs);
+    CrowdSimulation crowd;
+    crowd.setMoves(&moves);
+    crowd.reset(count);
+    size_t t = 0;
+    for (auto _ : state) {
+        crowd.update(&inputs[(t++ % ticks) * count], SIM_DT);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)count);
+    state.SetLabel(SCALAR_LABEL);
+}
+BENCHMARK(BM_Crowd)->RangeMultiplier(4)->Range(256, 16384)->Unit(benchmark::kMicrosecond);
+
+// A mix of fighters, projectiles and hazards at a fixed density along a line
+// that grows with the count, so the number of real overlaps grows linearly.
+static void fillBroadPhase(BroadPhase& broad, int count) {
+    static const uint8_t kinds[4] = { COLLIDER_FIGHTER, COLLIDER_FIGHTER, COLLIDER_PROJECTILE, COLLIDER_HAZARD };
+    static const float widths[4] = { 60.f, 60.f, 10.f, 100.f };
+    Rng rng(13);
+    float length = count * 40.f;
+    broad.clear();
+    for (int i = 0; i < count; ++i) {
+        int k = (int)(rng.next() & 3);
+        float x = (float)(rng.next() % 1000000) * 1e-6f * length;
+        broad.add(x, x + widths[k], kinds[k], (uint32_t)i);
+    }
+    broad.update();
+}
+
+static void BM_BroadPhasePairs(benchmark::State& state) {
+    BroadPhase broad;
+    fillBroadPhase(broad, (int)state.range(0));
+    std::vector<ColliderPair> pairs;
+    for (auto _ : state) {
+        pairs.clear();
+        broad.findPairs(COLLIDER_FIGHTER, COLLIDER_ALL, pairs);
+        benchmark::DoNotOptimize(pairs.data());
+    }
+    state.counters["pairs"] = (double)pairs.size();
+}
+BENCHMARK(BM_BroadPhasePairs)->RangeMultiplier(4)->Range(64, 65536);
+
+// The O(n^2) loop the broad phase replaces, for comparison.
+static void BM_BruteForcePairs(benchmark::State& state) {
+    BroadPhase broad;
+    fillBroadPhase(broad, (int)state.range(0));
+    size_t n = broad.size();
+    std::vector<ColliderPair> pairs;
+    for (auto _ : state) {
+        pairs.clear();
+        for (ColliderId a = 0; a < n; ++a)
+            for (ColliderId b = a + 1; b < n; ++b) {
+                if (!((broad.getKind(a) | broad.getKind(b)) & COLLIDER_FIGHTER)) continue;
+                if (broad.getMin(a) < broad.getMax(b) && broad.getMin(b) < broad.getMax(a)) pairs.push_back({ a, b });
+            }
+        benchmark::DoNotOptimize(pairs.data());
+    }
+    state.counters["pairs"] = (double)pairs.size();
+}
+BENCHMARK(BM_BruteForcePairs)->RangeMultiplier(4)->Range(64, 4096);
+
+// Every fighter asks who is within punch range.
+static void BM_BroadPhaseQuery(benchmark::State& state) {
+    BroadPhase broad;
+    fillBroadPhase(broad, (int)state.range(0));
+    std::vector<ColliderId> found;
+    for (auto _ : state) {
+        size_t total = 0;
+        for (ColliderId id = 0; id < broad.size(); ++id) {
+            if (broad.getKind(id) != COLLIDER_FIGHTER) continue;
+            float center = (broad.getMin(id) + broad.getMax(id)) * 0.5f;
+            found.clear();
+            broad.query(center - 60.f, center + 60.f, COLLIDER_ALL, found);
+            total += found.size();
+        }
+        benchmark::DoNotOptimize(total);
+    }
+}
+BENCHMARK(BM_BroadPhaseQuery)->RangeMultiplier(4)->Range(64, 65536);
+
+// SGG is not linked into the benchmark. These stand-ins take the same
+// arguments, so the draw path's own work and allocations can be measured.
+namespace graphics {
+void drawRect(float, float, float, float, const Brush& br) { benchmark::DoNotOptimize(&br); }
+void drawText(float, float, float, const std::string& text, const Brush&) { benchmark::DoNotOptimize(text.data()); }
+bool setFont(std::string fontname) { benchmark::DoNotOptimize(fontname.data()); return true; }
+}
+
+static const char* const FRAME_TEXTURES[4] = {
+    "assets\\arena_bg.png", "assets\\player1_idle.png", "assets\\player2_punch.png", "assets\\player1_ko.png"
+};
+static const std::string FRAME_FONT = "assets\\start_font.ttf";
+
+static void setAllocCounter(benchmark::State& state, uint64_t allocs) {
+    state.counters["allocs/frame"] = benchmark::Counter((double)allocs / state.iterations());
+}
+
+// One menu and arena frame drawn the way the game used to: a path string
+// copied into a Brush per sprite, setFont every frame and text passed as
+// char pointers. Build with KOMBAT_ALLOC_CHECK for the allocation counter.
+static void BM_DrawFrameStrings(benchmark::State& state) {
+    std::vector<std::string> paths(FRAME_TEXTURES, FRAME_TEXTURES + 4);
+    std::string label = "Play";
+    uint64_t before = allocCount();
+    for (auto _ : state) {
+        graphics::Brush br;
+        br.texture = paths[0];
+        graphics::drawRect(400.f, 300.f, 800.f, 600.f, br);
+        for (int h = 0; h < 2; ++h) {
+            std::string sprite = h ? paths[2] : paths[1];
+            br.texture = sprite;
+            graphics::drawRect(200.f + 400.f * h, 325.f, 80.f, 110.f, br);
+        }
+        graphics::Brush text;
+        graphics::drawText(280, 100, 40, "MY MENU", text);
+        if (label == "Play") graphics::setFont(FRAME_FONT);
+        graphics::drawText(360, 258, 24, label.c_str(), text);
+        graphics::drawText(220, 550, 20, "Use mouse to click the button, or ESC to quit.", text);
+    }
+    setAllocCounter(state, allocCount() - before);
+}
+BENCHMARK(BM_DrawFrameStrings);
+
+// The same frame through SpriteBatch: textures and text registered once and
+// referenced by id, and the font only set when it changes.
+static void BM_DrawFrame(benchmark::State& state) {
+    SpriteBatch batch;
+    TextureId tex[4];
+    for (int i = 0; i < 4; ++i) tex[i] = batch.registerTexture(FRAME_TEXTURES[i]);
+    TextId title = batch.registerText("MY MENU"), label = batch.registerText("Play");
+    TextId hint = batch.registerText("Use mouse to click the button, or ESC to quit.");
+    bool fontSet = false;
+    auto drawFrame = [&]() {
+        batch.add(tex[0], 400.f, 300.f, 800.f, 600.f);
+        for (int h = 0; h < 2; ++h)
+            batch.add(tex[1 + h], 200.f + 400.f * h, 325.f, 80.f, 110.f, 1);
+        batch.flush();
+        graphics::Brush text;
+        batch.drawText(title, 280, 100, 40, text);
+        if (!fontSet) { graphics::setFont(FRAME_FONT); fontSet = true; }
+        batch.drawText(label, 360, 258, 24, text);
+        batch.drawText(hint, 220, 550, 20, text);
+    };
+    // The first frame sizes the quad list and sets the font, as in the game.
+    drawFrame();
+    uint64_t before = allocCount();
+    for (auto _ : state) drawFrame();
+    setAllocCounter(state, allocCount() - before);
+}
+BENCHMARK(BM_DrawFrame);
+
+// KO bursts until count particles are live; a tiny dt keeps them alive so
+// every iteration steps the same number.
+static void fillParticles(ParticleSystem& p, size_t count) {
+    p.setFloor(435.f);
+    while (p.getLiveCount() < count) p.koBurst(400.f, 300.f);
+}
+
+static void BM_ParticleUpdate(benchmark::State& state) {
+    ParticleSystem particles((size_t)state.range(0));
+    fillParticles(particles, (size_t)state.range(0));
+    for (auto _ : state) particles.update(1e-6f);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParticleUpdate)->RangeMultiplier(4)->Range(1024, 65536);
+
+// Submitting the particles to a SpriteBatch and flushing it against the SGG stand-ins.
+static void BM_ParticleDraw(benchmark::State& state) {
+    SpriteBatch batch;
+    ParticleSystem particles((size_t)state.range(0));
+    particles.registerBrushes(batch);
+    fillParticles(particles, (size_t)state.range(0));
+    for (auto _ : state) {
+        particles.draw(batch.getQuads(), 2);
+        batch.flush();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParticleDraw)->RangeMultiplier(4)->Range(1024, 65536);
+
+// Entities cycling through eight clips of different lengths, switching clip
+// every so often, then looking up the texture to draw for each.
+static void BM_AnimStep(benchmark::State& state) {
+    size_t n = (size_t)state.range(0);
+    AnimationSet set;
+    for (int c = 0; c < 8; ++c) {
+        std::vector<TextureId> cells;
+        for (int i = 0; i <= c; ++i) cells.push_back((TextureId)(c * 8 + i));
+        set.addClip("clip" + std::to_string(c), cells, 4 + c, c % 2 == 0);
+    }
+    AnimPlayer player;
+    player.resize(n);
+    std::vector<ClipId> wanted(n);
+    uint32_t t = 0, sum = 0;
+    for (auto _ : state) {
+        for (size_t i = 0; i < n; ++i) wanted[i] = (ClipId)(((i * 7) + (t + i) / 64) & 7);
+        player.step(set, wanted.data(), 1);
+        for (size_t i = 0; i < n; ++i) sum += player.getTexture(set, i);
+        ++t;
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * (int64_t)n);
+}
+BENCHMARK(BM_AnimStep)->RangeMultiplier(8)->Range(64, 4096);
+
+static bool loadRasterTexture(const char* path, RasterTexture& tex) {
+    Image image;
+    if (!loadPng(path, image)) return false;
+    makeRasterTexture(image.rgba.data(), image.width, image.height, tex);
+    return true;
+}
+
+// An 800x600 arena frame in the software rasterizer: background, both
+// fighters and a KO burst's worth of particles. Run from the repo root.
+static void BM_RasterArenaFrame(benchmark::State& state) {
+    RasterTexture arena, idle, punch;
+    if (!loadRasterTexture("assets/arena_bg.png", arena) || !loadRasterTexture("assets/player1_idle.png", idle) ||
+        !loadRasterTexture("assets/player2_punch.png", punch)) {
+        state.SkipWithError("cannot load assets/");
+        return;
+    }
+    SpriteBatch batch;
+    ParticleSystem particles(4096);
+    particles.registerBrushes(batch);
+    fillParticles(particles, (size_t)state.range(0));
+    QuadList quads;
+    particles.draw(quads, 2);
+    Rasterizer raster;
+    raster.resize(800, 600);
+    RasterColor spark;
+    spark.g = 0.85f;
+    spark.b = 0.3f;
+    for (auto _ : state) {
+        raster.resetStats();
+        raster.fillRect(0.f, 0.f, 800.f, 600.f, RasterColor(), &arena);
+        raster.fillRect(260.f, 270.f, 340.f, 380.f, RasterColor(), &idle);
+        raster.fillRect(500.f, 270.f, 420.f, 380.f, RasterColor(), &punch);
+        for (const SpriteQuad& q : quads)
+            raster.fillRect(q.x - q.width * 0.5f, q.y - q.height * 0.5f, q.x + q.width * 0.5f, q.y + q.height * 0.5f, spark);
+        benchmark::DoNotOptimize(raster.getPixels());
+    }
+    state.counters["pixels"] = (double)raster.getStats().pixels;
+}
+BENCHMARK(BM_RasterArenaFrame)->Arg(0)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+// The per-tick desync hash over range(0) duels; one duel is the game's case.
+static void BM_StateHash(benchmark::State& state) {
+    Simulation sim;
+    sim.reset((int)state.range(0));
+    std::vector<uint8_t> buttons(sim.getFighters().size());
+    for (size_t i = 0; i < buttons.size(); ++i) buttons[i] = i & 1 ? INPUT_LEFT | INPUT_PUNCH : INPUT_RIGHT;
+    for (int i = 0; i < 60; ++i) sim.update(buttons.data(), SIM_DT);
+    StateHash h;
+    for (auto _ : state) {
+        hashState(sim, h);
+        benchmark::DoNotOptimize(h.combined);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StateHash)->Arg(1)->Arg(64)->Arg(1024);
+
+// One mixed block with range(0) effects playing, retriggered as they end.
+// A block is 2.9 ms of sound; the mix has to take a small part of that.
+static void BM_AudioMix(benchmark::State& state) {
+    int voices = (int)state.range(0);
+    AudioMixer mixer;
+    int16_t out[AUDIO_BLOCK * 2];
+    for (auto _ : state) {
+        for (int v = mixer.getActiveVoices(); v < voices; ++v) mixer.play((Sfx)(v % (int)Sfx::COUNT));
+        mixer.mix(out, AUDIO_BLOCK);
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations() * AUDIO_BLOCK);
+}
+BENCHMARK(BM_AudioMix)->Arg(0)->Arg(4)->Arg(AudioMixer::MAX_VOICES);
+
+BENCHMARK_MAIN();
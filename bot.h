@@ -0,0 +1,28 @@
+#pragma once
+#include "sim.h"
+
+// Scripted opponent used by the headless tools: walks in, punches at close
+// range and jumps now and then, with some noise from a xorshift generator.
+
+struct Rng {
+    uint32_t s;
+    explicit Rng(uint32_t seed) : s(seed ? seed : 1u) {}
+    uint32_t next() {
+        s ^= s << 13;
+        s ^= s >> 17;
+        s ^= s << 5;
+        return s;
+    }
+};
+
+inline uint8_t botInput(const FighterStore& f, FighterHandle self, FighterHandle other, Rng& rng) {
+    uint8_t buttons = 0;
+    uint32_t r = rng.next();
+    Scalar dx = f.x[other] - f.x[self];
+    Scalar dist = dx < 0.f ? -dx : dx;
+    if (dist > 55.f || (r & 7) == 0)
+        buttons |= dx > 0.f ? INPUT_RIGHT : INPUT_LEFT;
+    if (dist < 70.f && ((r >> 3) & 3) != 0) buttons |= INPUT_PUNCH;
+    if (((r >> 5) & 63) == 0) buttons |= INPUT_JUMP;
+    return buttons;
+}
@@ -0,0 +1,66 @@
+#include "collision.h"
+#include <algorithm>
+
+ColliderId BroadPhase::add(float left, float right, uint8_t colliderKind, uint32_t ownerId) {
+    ColliderId id = (ColliderId)minX.size();
+    minX.push_back(left);
+    maxX.push_back(right);
+    kind.push_back(colliderKind);
+    owner.push_back(ownerId);
+    order.push_back(id);
+    sortedMin.push_back(left);
+    return id;
+}
+
+void BroadPhase::clear() {
+    minX.clear(); maxX.clear(); kind.clear(); owner.clear();
+    order.clear(); sortedMin.clear();
+    maxWidth = 0.f;
+}
+
+void BroadPhase::reserve(size_t n) {
+    minX.reserve(n); maxX.reserve(n); kind.reserve(n); owner.reserve(n);
+    order.reserve(n); sortedMin.reserve(n);
+}
+
+void BroadPhase::update() {
+    size_t n = order.size();
+    for (size_t i = 1; i < n; ++i) {
+        ColliderId id = order[i];
+        float key = minX[id];
+        size_t j = i;
+        while (j > 0 && minX[order[j - 1]] > key) { order[j] = order[j - 1]; --j; }
+        order[j] = id;
+    }
+    maxWidth = 0.f;
+    for (size_t k = 0; k < n; ++k) {
+        ColliderId id = order[k];
+        sortedMin[k] = minX[id];
+        maxWidth = std::max(maxWidth, maxX[id] - minX[id]);
+    }
+}
+
+void BroadPhase::query(float lo, float hi, uint8_t kinds, std::vector<ColliderId>& out) const {
+    // Nothing is wider than maxWidth, so anything reaching past lo starts after lo - maxWidth.
+    size_t k = std::upper_bound(sortedMin.begin(), sortedMin.end(), lo - maxWidth) - sortedMin.begin();
+    for (size_t n = order.size(); k < n && sortedMin[k] < hi; ++k) {
+        ColliderId id = order[k];
+        if ((kind[id] & kinds) && maxX[id] > lo) out.push_back(id);
+    }
+}
+
+void BroadPhase::findPairs(uint8_t kindsA, uint8_t kindsB, std::vector<ColliderPair>& out) const {
+    size_t n = order.size();
+    for (size_t i = 0; i < n; ++i) {
+        ColliderId a = order[i];
+        uint8_t ka = kind[a];
+        if (!(ka & (kindsA | kindsB))) continue;
+        float right = maxX[a];
+        for (size_t j = i + 1; j < n && sortedMin[j] < right; ++j) {
+            ColliderId b = order[j];
+            uint8_t kb = kind[b];
+            if (((ka & kindsA) && (kb & kindsB)) || ((ka & kindsB) && (kb & kindsA)))
+                out.push_back({ a, b });
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Broad phase for anything that occupies a span of the arena line: fighters,
+// projectiles, hazards. Colliders are kept sorted by their left edge, so a
+// range query is a binary search plus a scan over the hits, and finding all
+// overlapping pairs is a single sweep: O(n log n + k) instead of O(n^2).
+
+enum ColliderKind : uint8_t {
+    COLLIDER_FIGHTER = 1 << 0,
+    COLLIDER_PROJECTILE = 1 << 1,
+    COLLIDER_HAZARD = 1 << 2,
+    COLLIDER_ALL = 0xff
+};
+
+// Index of a collider. Ids stay valid until the broad phase is cleared.
+typedef uint32_t ColliderId;
+
+struct ColliderPair {
+    ColliderId a, b;
+};
+
+class BroadPhase {
+private:
+    std::vector<float> minX, maxX;
+    std::vector<uint32_t> owner;
+    std::vector<uint8_t> kind;
+    // Ids sorted by minX, and minX in that order for the binary search.
+    std::vector<ColliderId> order;
+    std::vector<float> sortedMin;
+    float maxWidth = 0.f;
+public:
+    // owner is free for the caller, e.g. the FighterHandle the collider belongs to.
+    ColliderId add(float left, float right, uint8_t colliderKind, uint32_t ownerId);
+    void move(ColliderId id, float left, float right) { minX[id] = left; maxX[id] = right; }
+    void clear();
+    void reserve(size_t n);
+    // Re-sorts after moves. Insertion sort, so it is close to linear when
+    // things only moved a little since the last call.
+    void update();
+
+    // Colliders of the given kinds overlapping the open interval (lo, hi).
+    void query(float lo, float hi, uint8_t kinds, std::vector<ColliderId>& out) const;
+    // Overlapping pairs with one side in kindsA and the other in kindsB.
+    void findPairs(uint8_t kindsA, uint8_t kindsB, std::vector<ColliderPair>& out) const;
+
+    size_t size() const { return minX.size(); }
+    const std::vector<ColliderId>& getOrder() const { return order; }
+    float getMin(ColliderId id) const { return minX[id]; }
+    float getMax(ColliderId id) const { return maxX[id]; }
+    uint8_t getKind(ColliderId id) const { return kind[id]; }
+    uint32_t getOwner(ColliderId id) const { return owner[id]; }
+};
@@ -0,0 +1,187 @@
+#include "crowd.h"
+#include "moves.h"
+#include "simd.h"
+#include <algorithm>
+
+static const Scalar CROWD_RADIUS = 30.f;
+// Highest a jump gets: 300^2 / (2 * 600). Hitboxes reaching this far up and
+// down cannot miss on height, so they skip the per-pair test.
+static const Scalar CROWD_MAX_HEIGHT = 75.f;
+// Beyond the arena on either side, and inside Fixed's range.
+static const Scalar CROWD_SENTINEL = 30000.f;
+
+CrowdSimulation::CrowdSimulation() : moves(&defaultMoves()) {
+    reset(0);
+}
+
+void CrowdSimulation::setMoves(const MoveTable* table) {
+    moves = table ? table : &defaultMoves();
+}
+
+void CrowdSimulation::reset(int count) {
+    fighters.clear();
+    fighters.reserve((size_t)count);
+    broad.clear();
+    broad.reserve((size_t)count);
+    for (int i = 0; i < count; ++i) {
+        Scalar x = count > 1 ? 50.f + scalarRatio(700 * (int64_t)i, count - 1) : 400.f;
+        FighterHandle h = fighters.add(x, 0.f, params.speed);
+        float cx = toFloat(fighters.x[h]), r = toFloat(CROWD_RADIUS);
+        broad.add(cx - r, cx + r, COLLIDER_FIGHTER, h);
+    }
+    broad.update();
+    sortedX.assign((size_t)count + 2, 0.f);
+    damageDiff.assign((size_t)count + 1, 0.f);
+    pushDiff.assign((size_t)count + 1, 0.f);
+    damage.assign((size_t)count, 0.f);
+    push.assign((size_t)count, 0.f);
+}
+
+// Applies the gathered damage to fighters still standing; KO whoever drops to zero.
+static void applyHits(FighterStore& f, const Scalar* damage) {
+    size_t n = f.size(), i = 0;
+    Scalar* health = f.health.data();
+    AnimState* anim = f.anim.data();
+    uint16_t* moveFrame = f.moveFrame.data();
+#if KOMBAT_SIMD && !defined(KOMBAT_FIXED_POINT)
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 h0 = _mm_loadu_ps(health + i), taken = _mm_loadu_ps(damage + i);
+        __m128 hit = _mm_and_ps(_mm_cmpgt_ps(h0, zero), _mm_cmpneq_ps(taken, zero));
+        __m128 h = _mm_max_ps(_mm_sub_ps(h0, taken), zero);
+        _mm_storeu_ps(health + i, simdSelect(hit, h, h0));
+        __m128i ko = _mm_castps_si128(_mm_and_ps(hit, _mm_cmple_ps(h, zero)));
+        __m128i animIn = simdLoadBytes4((const uint8_t*)anim + i);
+        simdStoreBytes4((uint8_t*)anim + i, simdSelect(ko, _mm_set1_epi32((int)AnimState::KO), animIn));
+        int koMask = _mm_movemask_ps(_mm_castsi128_ps(ko));
+        for (int j = 0; koMask; ++j, koMask >>= 1)
+            if (koMask & 1) moveFrame[i + j] = 0;
+    }
+#endif
+    for (; i < n; ++i) {
+        if (health[i] <= 0.f || damage[i] == 0.f) continue;
+        health[i] -= damage[i];
+        if (health[i] < 0.f) health[i] = 0.f;
+        if (health[i] <= 0.f) {
+            anim[i] = AnimState::KO;
+            moveFrame[i] = 0;
+        }
+    }
+}
+
+// Each fighter moves half the overlap away from each sorted neighbour.
+// sx has sentinels at sx[-1] and sx[n] far outside the arena.
+static void separate(FighterStore& f, const Scalar* sx, const FighterHandle* order, size_t n) {
+    Scalar* x = f.x.data();
+    size_t k = 0;
+#if KOMBAT_SIMD && !defined(KOMBAT_FIXED_POINT)
+    const __m128 zero = _mm_setzero_ps(), gap = _mm_set1_ps(2 * CROWD_RADIUS), half = _mm_set1_ps(0.5f);
+    for (; k + 4 <= n; k += 4) {
+        __m128 prev = _mm_loadu_ps(sx + k - 1), cur = _mm_loadu_ps(sx + k), next = _mm_loadu_ps(sx + k + 1);
+        __m128 fromLeft = _mm_max_ps(_mm_sub_ps(gap, _mm_sub_ps(cur, prev)), zero);
+        __m128 fromRight = _mm_max_ps(_mm_sub_ps(gap, _mm_sub_ps(next, cur)), zero);
+        float out[4];
+        _mm_storeu_ps(out, _mm_add_ps(cur, _mm_mul_ps(_mm_sub_ps(fromLeft, fromRight), half)));
+        for (int j = 0; j < 4; ++j) x[order[k + j]] = out[j];
+    }
+#endif
+    for (; k < n; ++k) {
+        Scalar fromLeft = 2 * CROWD_RADIUS - (sx[k] - sx[k - 1]);
+        Scalar fromRight = 2 * CROWD_RADIUS - (sx[k + 1] - sx[k]);
+        if (fromLeft < 0.f) fromLeft = 0.f;
+        if (fromRight < 0.f) fromRight = 0.f;
+        x[order[k]] = sx[k] + (fromLeft - fromRight) * 0.5f;
+    }
+}
+
+void CrowdSimulation::update(const uint8_t* buttons, float dt) {
+    updateFighters(fighters, buttons, dt, *moves);
+    size_t n = fighters.size();
+    if (n == 0) return;
+    const Scalar* x = fighters.x.data();
+
+    for (size_t h = 0; h < n; ++h) broad.move((ColliderId)h, toFloat(x[h] - CROWD_RADIUS), toFloat(x[h] + CROWD_RADIUS));
+    broad.update();
+    const std::vector<ColliderId>& order = broad.getOrder();
+
+    Scalar* sx = sortedX.data() + 1;
+    sortedX[0] = -CROWD_SENTINEL;
+    sortedX[n + 1] = CROWD_SENTINEL;
+    for (size_t k = 0; k < n; ++k) sx[k] = x[order[k]];
+
+    // An active hitbox covers a contiguous run of the sorted fighters, found
+    // by binary search, so its damage and knockback are range adds into
+    // difference arrays. Hitboxes limited in height need the per-pair y test
+    // instead: they ask the broad phase who is in range. Colliders are the
+    // fighter's center +-CROWD_RADIUS, so the query is shrunk by the radius.
+    std::fill(damageDiff.begin(), damageDiff.end(), 0.f);
+    std::fill(pushDiff.begin(), pushDiff.end(), 0.f);
+    std::fill(damage.begin(), damage.end(), 0.f);
+    std::fill(push.begin(), push.end(), 0.f);
+    const MoveTable& table = *moves;
+    for (size_t k = 0; k < n; ++k) {
+        FighterHandle a = order[k];
+        const MoveFrame& fr = table.getFrame(fighters.moveFrame[a]);
+        if (!(fr.flags & FRAME_ACTIVE)) continue;
+        // The hitbox is given facing right; a fighter faces its nearest
+        // neighbour, the sentinels keeping the outermost ones facing in.
+        Scalar left = fr.hitLeft, right = fr.hitRight;
+        if (sx[k] - sx[k - 1] < sx[k + 1] - sx[k]) {
+            left = -fr.hitRight;
+            right = -fr.hitLeft;
+        }
+
+        if (fr.hitBottom <= -CROWD_MAX_HEIGHT && fr.hitTop >= CROWD_MAX_HEIGHT) {
+            size_t lo = std::upper_bound(sx, sx + n, sx[k] + left) - sx;
+            size_t hi = std::lower_bound(sx, sx + n, sx[k] + right) - sx;
+            if (lo >= hi) continue;
+            size_t mid = std::min(std::max((size_t)(std::lower_bound(sx, sx + n, sx[k]) - sx), lo), hi);
+            damageDiff[lo] += fr.damage;
+            damageDiff[hi] -= fr.damage;
+            pushDiff[lo] -= fr.knockback;
+            pushDiff[mid] += 2 * fr.knockback;
+            pushDiff[hi] -= fr.knockback;
+            if (k >= lo && k < hi) {
+                // Not itself.
+                damage[a] -= fr.damage;
+                push[a] -= fr.knockback;
+            }
+            continue;
+        }
+
+        found.clear();
+        broad.query(toFloat(x[a] + left + CROWD_RADIUS), toFloat(x[a] + right - CROWD_RADIUS), COLLIDER_FIGHTER, found);
+        for (ColliderId t : found) {
+            if (t == a) continue;
+            Scalar dx = x[t] - x[a], dy = fighters.y[t] - fighters.y[a];
+            if (dx <= left || dx >= right || dy < fr.hitBottom || dy > fr.hitTop) continue;
+            damage[t] += fr.damage;
+            push[t] += dx < 0.f ? -fr.knockback : fr.knockback;
+        }
+    }
+    Scalar runDamage = 0.f, runPush = 0.f;
+    for (size_t k = 0; k < n; ++k) {
+        FighterHandle t = order[k];
+        runDamage += damageDiff[k];
+        runPush += pushDiff[k];
+        damage[t] += runDamage;
+        push[t] += runPush;
+        if (table.getFrame(fighters.moveFrame[t]).flags & FRAME_GUARD) {
+            damage[t] = 0.f;
+            push[t] = 0.f;
+        }
+    }
+    applyHits(fighters, damage.data());
+    for (size_t k = 0; k < n; ++k) {
+        Scalar p = push[order[k]];
+        if (p != 0.f && fighters.anim[order[k]] != AnimState::KO) sx[k] = std::min<Scalar>(750.f, std::max<Scalar>(50.f, sx[k] + p));
+    }
+    separate(fighters, sx, order.data(), n);
+}
+
+int CrowdSimulation::getAliveCount() const {
+    int alive = 0;
+    for (Scalar h : fighters.health)
+        if (h > 0.f) ++alive;
+    return alive;
+}
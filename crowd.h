@@ -0,0 +1,44 @@
+#pragma once
+#include "collision.h"
+#include "sim.h"
+#include <vector>
+
+// Free-for-all crowd mode: every fighter shares the one arena line and can
+// hit or bump into any other. Fighters are kept sorted by the broad phase:
+// an active move queries it for everything inside its hitbox, and overlaps
+// only need checking between sorted neighbours.
+// Hits and pushes are resolved simultaneously from the state at the start of
+// the pass, so the result does not depend on handle order. The broad phase
+// keeps float bounds; in fixed-point builds they are converted from the
+// fighters' positions and only pick candidates, and the hit test itself is in
+// Scalar.
+class CrowdSimulation {
+private:
+    FighterStore fighters;
+    FightParams params;
+    const MoveTable* moves;
+    // One collider per fighter, with ColliderId == FighterHandle.
+    BroadPhase broad;
+    // Scratch: x in sorted order with one sentinel on each side, damage and
+    // knockback as difference arrays over sorted order, and the same per handle.
+    std::vector<Scalar> sortedX;
+    std::vector<Scalar> damageDiff, pushDiff;
+    std::vector<Scalar> damage, push;
+    std::vector<ColliderId> found;
+public:
+    CrowdSimulation();
+
+    // Spreads count fighters evenly over the arena.
+    void reset(int count);
+    void setParams(const FightParams& p) { params = p; }
+    const FightParams& getParams() const { return params; }
+    // The table must outlive the simulation; nullptr means defaultMoves().
+    void setMoves(const MoveTable* table);
+    // buttons holds one byte of InputBits per fighter handle.
+    void update(const uint8_t* buttons, float dt);
+
+    FighterStore& getFighters() { return fighters; }
+    const FighterStore& getFighters() const { return fighters; }
+    const BroadPhase& getBroadPhase() const { return broad; }
+    int getAliveCount() const;
+};
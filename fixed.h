@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+
+// Q16.16 fixed-point number: a 32-bit integer counting 1/65536ths, so the
+// range is about +-32767, which covers the arena, health and velocities.
+// Addition and subtraction are exact. Products and quotients are widened to
+// 64 bits and rounded toward minus infinity by an arithmetic shift, which
+// every compiler this builds with does for signed values. The results depend
+// only on the inputs, whatever the compiler, its optimization level or the
+// CPU's float unit.
+//
+// Building with KOMBAT_FIXED_POINT makes Scalar, the simulation's number
+// type, Fixed instead of float. Replays and netplay only agree between
+// builds that use the same Scalar. Code outside the sim reads values
+// through toFloat().
+
+class Fixed {
+private:
+    int32_t raw = 0;
+
+    // Nearest step to v, rounding halves away from zero. The scaling is by a
+    // power of two and the fraction is taken from an integer part that is
+    // close to it, so every float operation here is exact.
+    static constexpr int32_t rawFromFloat(float v) {
+        float scaled = v * (float)ONE;
+        int32_t whole = (int32_t)scaled;
+        float frac = scaled - (float)whole;
+        return frac >= 0.5f ? whole + 1 : frac <= -0.5f ? whole - 1 : whole;
+    }
+public:
+    static const int FRAC_BITS = 16;
+    static const int32_t ONE = 1 << FRAC_BITS;
+
+    constexpr Fixed() {}
+    constexpr Fixed(int v) : raw(v * ONE) {}
+    constexpr Fixed(float v) : raw(rawFromFloat(v)) {}
+    static constexpr Fixed fromRaw(int32_t r) {
+        Fixed f;
+        f.raw = r;
+        return f;
+    }
+    // num / den, rounded toward zero, without going through a float.
+    static constexpr Fixed fromRatio(int64_t num, int64_t den) { return fromRaw((int32_t)(num * ONE / den)); }
+    constexpr int32_t getRaw() const { return raw; }
+    constexpr float toFloat() const { return (float)raw * (1.f / ONE); }
+
+    constexpr Fixed operator-() const { return fromRaw(-raw); }
+    friend constexpr Fixed operator+(Fixed a, Fixed b) { return fromRaw(a.raw + b.raw); }
+    friend constexpr Fixed operator-(Fixed a, Fixed b) { return fromRaw(a.raw - b.raw); }
+    friend constexpr Fixed operator*(Fixed a, Fixed b) {
+        return fromRaw((int32_t)(((int64_t)a.raw * b.raw) >> FRAC_BITS));
+    }
+    friend constexpr Fixed operator/(Fixed a, Fixed b) {
+        return fromRaw((int32_t)(((int64_t)a.raw * ONE) / b.raw));
+    }
+    Fixed& operator+=(Fixed o) { raw += o.raw; return *this; }
+    Fixed& operator-=(Fixed o) { raw -= o.raw; return *this; }
+    Fixed& operator*=(Fixed o) { return *this = *this * o; }
+    Fixed& operator/=(Fixed o) { return *this = *this / o; }
+
+    friend constexpr bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+    friend constexpr bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+    friend constexpr bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+    friend constexpr bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+    friend constexpr bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+    friend constexpr bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+};
+
+static_assert(Fixed(0.5f).getRaw() == Fixed::ONE / 2, "Fixed from float");
+static_assert(Fixed(-1.f / 3.f).getRaw() == -21845, "Fixed rounds to nearest");
+static_assert((Fixed(3) * Fixed(-0.25f)).getRaw() == -3 * Fixed::ONE / 4, "Fixed multiply");
+
+// SCALAR_MODE is stored in replay and hash log headers, so a file is only
+// loaded by the kind of build that can reproduce it: 0 float, 1 fixed.
+#ifdef KOMBAT_FIXED_POINT
+typedef Fixed Scalar;
+const uint8_t SCALAR_MODE = 1;
+#else
+typedef float Scalar;
+const uint8_t SCALAR_MODE = 0;
+#endif
+
+constexpr float toFloat(float v) { return v; }
+constexpr float toFloat(Fixed v) { return v.toFloat(); }
+
+// num / den as a Scalar, for sim values derived from counts.
+#ifdef KOMBAT_FIXED_POINT
+constexpr Scalar scalarRatio(int64_t num, int64_t den) { return Fixed::fromRatio(num, den); }
+#else
+constexpr Scalar scalarRatio(int64_t num, int64_t den) { return (float)num / (float)den; }
+#endif
@@ -0,0 +1,41 @@
+#include "golden.h"
+#include <cstdlib>
+
+static int pixelDelta(const uint8_t* p, const uint8_t* q) {
+    int delta = 0;
+    for (int c = 0; c < 4; ++c) {
+        int d = abs(p[c] - q[c]);
+        if (d > delta) delta = d;
+    }
+    return delta;
+}
+
+ImageDiff compareImages(const Image& a, const Image& b, int tolerance) {
+    ImageDiff diff;
+    if (a.width != b.width || a.height != b.height) {
+        diff.sameSize = false;
+        return diff;
+    }
+    for (size_t i = 0; i < a.rgba.size(); i += 4) {
+        int d = pixelDelta(&a.rgba[i], &b.rgba[i]);
+        if (d > diff.maxDelta) diff.maxDelta = d;
+        if (d > tolerance) ++diff.differing;
+    }
+    return diff;
+}
+
+void diffImage(const Image& a, const Image& b, int tolerance, Image& out) {
+    out = b;
+    bool same = a.width == b.width && a.height == b.height;
+    for (size_t i = 0; i < out.rgba.size(); i += 4) {
+        uint8_t* p = &out.rgba[i];
+        if (same && pixelDelta(&a.rgba[i], p) > tolerance) {
+            p[0] = 255;
+            p[1] = p[2] = 0;
+        }
+        else {
+            for (int c = 0; c < 3; ++c) p[c] /= 4;
+        }
+        p[3] = 255;
+    }
+}
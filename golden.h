@@ -0,0 +1,17 @@
+#pragma once
+#include "png.h"
+#include <cstddef>
+
+// Image comparison for the golden-image check (--golden in software
+// renderer builds): a rendered frame passes when few enough pixels differ
+// from the stored reference by more than a small per-channel tolerance.
+
+struct ImageDiff {
+    bool sameSize = true;
+    size_t differing = 0;   // pixels with a channel more than the tolerance apart
+    int maxDelta = 0;       // largest channel difference anywhere
+};
+
+ImageDiff compareImages(const Image& a, const Image& b, int tolerance);
+// b dimmed, with the pixels that differ from a beyond tolerance in red.
+void diffImage(const Image& a, const Image& b, int tolerance, Image& out);
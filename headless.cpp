@@ -0,0 +1,62 @@
+#include "bot.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Headless match driver: steps the fight simulation with scripted bot input,
+// no window or SGG required. Usage: headless [matches] [seed] [duels]
+// With duels > 1 that many matches run side by side in one Simulation.
+
+int main(int argc, char** argv) {
+    int matches = argc > 1 ? atoi(argv[1]) : 10000;
+    uint32_t seed = argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 10) : 1u;
+    int duels = argc > 3 ? atoi(argv[3]) : 1;
+    if (duels < 1) duels = 1;
+    const int maxTicks = SIM_HZ * 99;
+
+    Rng rng(seed);
+    Simulation sim;
+    std::vector<uint8_t> buttons;
+    long long totalTicks = 0, fighterTicks = 0;
+    int wins[2] = { 0, 0 }, draws = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int m = 0; m < matches; m += duels) {
+        int count = matches - m < duels ? matches - m : duels;
+        sim.reset(count);
+        FighterStore& f = sim.getFighters();
+        buttons.assign(f.size(), 0);
+        int tick = 0;
+        bool running = true;
+        while (tick < maxTicks && running) {
+            running = false;
+            for (int d = 0; d < count; ++d) {
+                FighterHandle p1 = (FighterHandle)d * 2, p2 = p1 + 1;
+                buttons[p1] = botInput(f, p1, p2, rng);
+                buttons[p2] = botInput(f, p2, p1, rng);
+            }
+            sim.update(buttons.data(), SIM_DT);
+            ++tick;
+            for (int d = 0; d < count && !running; ++d)
+                if (!sim.isOver(d)) running = true;
+        }
+        totalTicks += tick;
+        fighterTicks += (long long)tick * f.size();
+        for (int d = 0; d < count; ++d) {
+            int w = sim.getWinner(d);
+            if (w < 0) ++draws;
+            else ++wins[w];
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double secs = std::chrono::duration<double>(end - start).count();
+
+    printf("matches: %d  duels/sim: %d  ticks: %lld  p1 wins: %d  p2 wins: %d  draws: %d\n",
+        matches, duels, totalTicks, wins[0], wins[1], draws);
+    printf("time: %.3f s  matches/s: %.0f  ticks/s: %.0f  ns/tick: %.1f  ns/fighter-tick: %.2f\n",
+        secs, matches / secs, totalTicks / secs,
+        totalTicks ? secs * 1e9 / totalTicks : 0.0,
+        fighterTicks ? secs * 1e9 / fighterTicks : 0.0);
+    return 0;
+}
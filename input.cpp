@@ -0,0 +1,189 @@
+#include "input.h"
+#include "sim.h"
+#include <sgg/scancodes.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+using namespace graphics;
+
+void InputHistory::push(uint8_t buttons, uint32_t tick) {
+    uint8_t prev = count ? get(0).buttons : 0;
+    samples[count & (HISTORY_SIZE - 1)] = { buttons, tick };
+    ++count;
+    uint8_t pressed = buttons & ~prev;
+    for (int b = 0; b < 8; ++b) {
+        if (!(pressed & (1 << b))) continue;
+        pressTick[b] = tick;
+        pending |= (uint8_t)(1 << b);
+    }
+}
+
+uint8_t InputHistory::getBuffered(uint8_t mask, int window) const {
+    if (count == 0) return 0;
+    uint32_t now = get(0).tick;
+    uint8_t out = 0;
+    for (int b = 0; b < 8; ++b) {
+        uint8_t bit = (uint8_t)(1 << b);
+        if ((pending & mask & bit) && now - pressTick[b] < (uint32_t)window) out |= bit;
+    }
+    return out;
+}
+
+uint8_t InputHistory::getBufferedAfter(uint8_t buttons, uint32_t tick, uint8_t mask, int window) const {
+    uint8_t pressed = buttons & ~(count ? get(0).buttons : 0);
+    uint8_t out = 0;
+    for (int b = 0; b < 8; ++b) {
+        uint8_t bit = (uint8_t)(1 << b);
+        if (!(mask & bit)) continue;
+        if (pressed & bit) out |= window > 0 ? bit : 0;
+        else if ((pending & bit) && tick - pressTick[b] < (uint32_t)window) out |= bit;
+    }
+    return out;
+}
+
+InputBindings::InputBindings() {
+    bindings = {
+        { SCANCODE_A, 0, INPUT_LEFT }, { SCANCODE_D, 0, INPUT_RIGHT },
+        { SCANCODE_W, 0, INPUT_JUMP }, { SCANCODE_G, 0, INPUT_PUNCH },
+        { SCANCODE_LEFT, 1, INPUT_LEFT }, { SCANCODE_RIGHT, 1, INPUT_RIGHT },
+        { SCANCODE_UP, 1, INPUT_JUMP }, { SCANCODE_RCTRL, 1, INPUT_PUNCH }
+    };
+    bufferMask = INPUT_PUNCH;
+    bufferTicks = 8;
+}
+
+static const struct { const char* name; int key; } KEY_NAMES[] = {
+    { "left", SCANCODE_LEFT }, { "right", SCANCODE_RIGHT }, { "up", SCANCODE_UP }, { "down", SCANCODE_DOWN },
+    { "space", SCANCODE_SPACE }, { "enter", SCANCODE_RETURN }, { "tab", SCANCODE_TAB },
+    { "lctrl", SCANCODE_LCTRL }, { "rctrl", SCANCODE_RCTRL }, { "lshift", SCANCODE_LSHIFT },
+    { "rshift", SCANCODE_RSHIFT }, { "lalt", SCANCODE_LALT }, { "ralt", SCANCODE_RALT },
+    { "comma", SCANCODE_COMMA }, { "period", SCANCODE_PERIOD }, { "slash", SCANCODE_SLASH },
+    { "semicolon", SCANCODE_SEMICOLON }
+};
+
+static int parseKey(const std::string& name) {
+    if (name.size() == 1 && name[0] >= 'a' && name[0] <= 'z') return SCANCODE_A + (name[0] - 'a');
+    if (name.size() == 1 && name[0] >= '1' && name[0] <= '9') return SCANCODE_1 + (name[0] - '1');
+    if (name == "0") return SCANCODE_0;
+    if (name.size() == 3 && name.compare(0, 2, "kp") == 0 && name[2] >= '1' && name[2] <= '9')
+        return SCANCODE_KP_1 + (name[2] - '1');
+    if (name == "kp0") return SCANCODE_KP_0;
+    for (const auto& k : KEY_NAMES)
+        if (name == k.name) return k.key;
+    return -1;
+}
+
+static int parseButton(const std::string& name) {
+    if (name == "left") return INPUT_LEFT;
+    if (name == "right") return INPUT_RIGHT;
+    if (name == "jump") return INPUT_JUMP;
+    if (name == "punch") return INPUT_PUNCH;
+    return 0;
+}
+
+bool InputBindings::parse(const std::string& text) {
+    std::vector<InputBinding> parsed;
+    uint8_t mask = 0;
+    int ticks = 0;
+    std::istringstream lines(text);
+    std::string line;
+    int lineNo = 0;
+    auto fail = [&](const std::string& what) {
+        error = "line " + std::to_string(lineNo) + ": " + what;
+        return false;
+    };
+
+    while (std::getline(lines, line)) {
+        ++lineNo;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.resize(hash);
+        std::istringstream in(line);
+        std::string first, name;
+        if (!(in >> first)) continue;
+        if (first == "buffer") {
+            if (!(in >> ticks) || ticks < 0 || ticks > InputHistory::HISTORY_SIZE) return fail("bad buffer length");
+            while (in >> name) {
+                int button = parseButton(name);
+                if (!button) return fail("unknown button " + name);
+                mask |= (uint8_t)button;
+            }
+            continue;
+        }
+        if (first.size() != 2 || first[0] != 'p' || first[1] < '1' || first[1] >= '1' + INPUT_PLAYERS)
+            return fail("expected p1, p2 or buffer");
+        int button = (in >> name) ? parseButton(name) : 0;
+        if (!button) return fail("expected a button: left right jump punch");
+        int keys = 0;
+        while (in >> name) {
+            int key = parseKey(name);
+            if (key < 0) return fail("unknown key " + name);
+            parsed.push_back({ (uint16_t)key, (uint8_t)(first[1] - '1'), (uint8_t)button });
+            ++keys;
+        }
+        if (keys == 0) return fail("no keys");
+    }
+    bindings = parsed;
+    bufferMask = mask;
+    bufferTicks = ticks;
+    error.clear();
+    return true;
+}
+
+bool InputBindings::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    if (!parse(text.str())) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+InputSystem::InputSystem() {
+    setBindings(InputBindings());
+}
+
+void InputSystem::setBindings(const InputBindings& b) {
+    bindings = b;
+    keys.clear();
+    for (const InputBinding& ib : bindings.getBindings()) keys.push_back(ib.key);
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    reset();
+}
+
+void InputSystem::poll(bool (*keyDown)(int key)) {
+    std::fill(down, down + INPUT_MAX_KEYS / 64, 0);
+    for (uint16_t k : keys)
+        if (keyDown(k)) down[k >> 6] |= 1ull << (k & 63);
+    std::fill(buttons, buttons + INPUT_PLAYERS, 0);
+    for (const InputBinding& b : bindings.getBindings())
+        if (down[b.key >> 6] & (1ull << (b.key & 63))) buttons[b.player] |= b.button;
+}
+
+void InputSystem::tickInput(uint8_t* out) {
+    for (int p = 0; p < INPUT_PLAYERS; ++p) {
+        InputHistory& h = history[p];
+        h.push(buttons[p], tick);
+        out[p] = buttons[p] | h.getBuffered(bindings.getBufferMask(), bindings.getBufferTicks());
+    }
+    ++tick;
+}
+
+void InputSystem::peekInput(uint8_t* out) const {
+    for (int p = 0; p < INPUT_PLAYERS; ++p)
+        out[p] = buttons[p] | history[p].getBufferedAfter(buttons[p], tick, bindings.getBufferMask(), bindings.getBufferTicks());
+}
+
+void InputSystem::reset() {
+    std::fill(down, down + INPUT_MAX_KEYS / 64, 0);
+    std::fill(buttons, buttons + INPUT_PLAYERS, 0);
+    for (InputHistory& h : history) h.clear();
+    tick = 0;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Keyboard input for the local players. Each frame poll() reads every bound
+// key exactly once into a bitset and folds it into one byte of InputBits per
+// player; each sim tick then takes its buttons with tickInput(), which also
+// records them in the players' histories for buffering.
+//
+// Bindings file format, one binding per line, '#' starts a comment:
+//   p1 left a              player, button (left right jump punch), key names
+//   p2 punch rctrl enter   more than one key can drive a button
+//   buffer 8 punch         presses of these buttons count for this many ticks
+// Key names are letters, digits, kp0-kp9 and the names in input.cpp.
+
+const int INPUT_PLAYERS = 2;
+const int INPUT_MAX_KEYS = 512;
+
+struct InputBinding {
+    uint16_t key;       // SDL scancode
+    uint8_t player;
+    uint8_t button;     // InputBits
+};
+
+struct InputSample {
+    uint8_t buttons;
+    uint32_t tick;
+};
+
+// The last HISTORY_SIZE ticks of one player's buttons.
+class InputHistory {
+public:
+    static const int HISTORY_SIZE = 64;
+private:
+    InputSample samples[HISTORY_SIZE];
+    uint32_t count = 0;
+    // Tick of the latest press of each button not yet used by a move.
+    uint32_t pressTick[8];
+    uint8_t pending = 0;
+public:
+    void clear() { count = 0; pending = 0; }
+    void push(uint8_t buttons, uint32_t tick);
+    int size() const { return count < HISTORY_SIZE ? (int)count : HISTORY_SIZE; }
+    // ago 0 is the latest sample; ago must be below size().
+    const InputSample& get(int ago) const { return samples[(count - 1 - ago) & (HISTORY_SIZE - 1)]; }
+    // Buttons in mask pressed within the last window ticks and not consumed since.
+    uint8_t getBuffered(uint8_t mask, int window) const;
+    // What getBuffered() would return after push(buttons, tick).
+    uint8_t getBufferedAfter(uint8_t buttons, uint32_t tick, uint8_t mask, int window) const;
+    void consume(uint8_t buttons) { pending &= ~buttons; }
+};
+
+class InputBindings {
+private:
+    std::vector<InputBinding> bindings;
+    uint8_t bufferMask = 0;
+    int bufferTicks = 0;
+    std::string error;
+public:
+    // The default layout: WASD + G for player 1, arrows + right ctrl for player 2.
+    InputBindings();
+
+    // Replaces the bindings; false leaves them unchanged and sets getError().
+    bool parse(const std::string& text);
+    bool load(const std::string& path);
+
+    const std::vector<InputBinding>& getBindings() const { return bindings; }
+    uint8_t getBufferMask() const { return bufferMask; }
+    int getBufferTicks() const { return bufferTicks; }
+    const std::string& getError() const { return error; }
+};
+
+class InputSystem {
+private:
+    InputBindings bindings;
+    std::vector<uint16_t> keys;     // distinct bound keys, read once per poll
+    uint64_t down[INPUT_MAX_KEYS / 64];
+    uint8_t buttons[INPUT_PLAYERS];
+    InputHistory history[INPUT_PLAYERS];
+    uint32_t tick = 0;
+public:
+    InputSystem();
+
+    void setBindings(const InputBindings& b);
+    const InputBindings& getBindings() const { return bindings; }
+
+    // Reads every bound key through keyDown and updates each player's buttons.
+    void poll(bool (*keyDown)(int key));
+    // The buttons from the last poll, without buffering.
+    uint8_t getButtons(int player) const { return buttons[player]; }
+    // Records the buttons for the next sim tick in every player's history and
+    // writes them to out, one byte per player, with buffered presses added.
+    void tickInput(uint8_t* out);
+    // The same buttons tickInput() would give, without recording them: for
+    // netplay, where the tick only happens if the peer has caught up.
+    void peekInput(uint8_t* out) const;
+    // Call when the player's fighter starts a move so a buffered press does not start it twice.
+    void moveStarted(int player) { history[player].consume(bindings.getBufferMask()); }
+    const InputHistory& getHistory(int player) const { return history[player]; }
+    void reset();
+};
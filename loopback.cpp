@@ -0,0 +1,100 @@
+#include "bot.h"
+#include "rollback.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Plays two rollback peers against each other over UDP on 127.0.0.1 with a
+// simulated latency/loss shim, then checks that both ended in the same state
+// as an offline run of the confirmed inputs.
+// Usage: loopback [frames] [latency ms] [loss %]
+
+static bool sameState(const Simulation& a, const Simulation& b) {
+    const FighterStore& fa = a.getFighters();
+    const FighterStore& fb = b.getFighters();
+    return fa.x == fb.x && fa.y == fb.y && fa.vy == fb.vy && fa.health == fb.health &&
+        fa.jumping == fb.jumping && fa.anim == fb.anim && fa.moveFrame == fb.moveFrame;
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 3600;
+    double latency = argc > 2 ? atof(argv[2]) : 50.0;
+    int loss = argc > 3 ? atoi(argv[3]) : 5;
+
+    NetplaySession peers[2];
+    if (!peers[0].start(0, 47001, "127.0.0.1", 47002) ||
+        !peers[1].start(1, 47002, "127.0.0.1", 47001)) {
+        printf("failed to open loopback sockets\n");
+        return 1;
+    }
+    peers[0].setConditions(latency, loss, 11);
+    peers[1].setConditions(latency, loss, 23);
+
+    std::vector<uint8_t> history[2];
+    Rng rng[2] = { Rng(0x1234u), Rng(0x5678u) };
+    double tickMs = 1000.0 / SIM_HZ;
+    double now = 0.0, worstAdvanceUs = 0.0, totalAdvanceUs = 0.0;
+    int advances = 0, stalls = 0;
+
+    // Virtual clock: each iteration is one 120 Hz frame on both machines.
+    while ((int)history[0].size() < frames || (int)history[1].size() < frames) {
+        for (int p = 0; p < 2; ++p) {
+            NetplaySession& peer = peers[p];
+            peer.poll(now);
+            int32_t f = peer.getRollback().getFrame();
+            if (f >= frames) { peer.sendInputs(now); continue; }
+            FighterHandle self = (FighterHandle)p, other = (FighterHandle)(1 - p);
+            uint8_t buttons = botInput(peer.getSim().getFighters(), self, other, rng[p]);
+
+            auto t0 = std::chrono::steady_clock::now();
+            bool stepped = peer.advance(buttons, now);
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+            if (stepped) {
+                history[p].push_back(buttons);
+                totalAdvanceUs += us;
+                ++advances;
+                if (us > worstAdvanceUs) worstAdvanceUs = us;
+            }
+            else {
+                ++stalls;
+            }
+        }
+        now += tickMs;
+    }
+
+    // Let the last inputs arrive so both sides settle on confirmed state.
+    for (int i = 0; i < 1000; ++i) {
+        bool settled = true;
+        for (int p = 0; p < 2; ++p) {
+            peers[p].poll(now);
+            if (peers[p].getRollback().getConfirmedRemote() < frames - 1) settled = false;
+            peers[p].sendInputs(now);
+        }
+        if (settled) break;
+        now += tickMs;
+    }
+    peers[0].getRollback().applyRollback();
+    peers[1].getRollback().applyRollback();
+
+    Simulation reference;
+    for (int f = 0; f < frames; ++f) {
+        uint8_t buttons[2] = { history[0][f], history[1][f] };
+        reference.update(buttons, SIM_DT);
+    }
+
+    bool ok = sameState(peers[0].getSim(), reference) && sameState(peers[1].getSim(), reference);
+    for (int p = 0; p < 2; ++p) {
+        RollbackSession& r = peers[p].getRollback();
+        printf("peer %d: rollbacks %d  resimulated %d  max depth %d  sent %d  dropped %d  hashes checked %d\n",
+            p, r.getRollbacks(), r.getResimulatedFrames(), r.getMaxResimulated(),
+            peers[p].getLink().getSentPackets(), peers[p].getLink().getDroppedPackets(), peers[p].getCheckedHashes());
+        if (peers[p].getDesyncFrame() >= 0) {
+            printf("peer %d: hash mismatch at frame %d\n", p, peers[p].getDesyncFrame());
+            ok = false;
+        }
+    }
+    printf("frames %d  stalls %d  advance avg %.2f us  worst %.2f us\n",
+        frames, stalls, advances ? totalAdvanceUs / advances : 0.0, worstAdvanceUs);
+    printf("%s\n", ok ? "peers in sync" : "DESYNC");
+    return ok ? 0 : 1;
+}
@@ -1,7 +1,29 @@
 #include "sgg/graphics.h"
+#include "alloccheck.h"
+#include "anim.h"
+#include "assets.h"
+#include "audio.h"
+#include "input.h"
+#include "moves.h"
+#include "particles.h"
+#include "pipeline.h"
+#include "pool.h"
+#include "profiler.h"
+#include "replay.h"
+#include "rollback.h"
+#include "sim.h"
+#include "spritebatch.h"
+#include "statehash.h"
+#ifdef KOMBAT_SOFT_GFX
+#include "golden.h"
+#include "softgfx.h"
+#endif
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 
 enum class ScreenState { MENU, GAME, EXIT };
 
@@ -31,245 +53,520 @@ public:
 int GameObject::next_id = 0;
 
 
-enum class AnimState { IDLE, PUNCHING, KO };
+// Canvas y of a fighter at sim height 0, and half the sprite's height.
+static const float GROUND_Y = 380.f;
+static const float FIGHTER_HALF_HEIGHT = 55.f;
 
-class Fighter : public GameObject {
+class MenuButton : public GameObject {
 private:
-    float x = 0.f, y = 0.f, speed = 200.f;
-    float health = 100.f;
-    bool jumping = false;
-    float vy = 0.f, punchCooldown = 0.f;
-    AnimState anim = AnimState::IDLE;
-    std::string spriteIdle, spritePunch, spriteKO;
-
+    float x, y, width, height;
+    std::string label;
+    FontHandle font;
 public:
-    Fighter(GameState* gs, const std::string& name) : GameObject(gs, name) {}
-
-    
-    void setSprites(const std::string& idle,
-        const std::string& punch,
-        const std::string& ko) {
-        spriteIdle = idle;
-        spritePunch = punch;
-        spriteKO = ko;
-    }
-    void setPosition(float px, float py) { x = px; y = py; }
-    float getHealth() const { return health; }
-    void setHealth(float h) { health = h; }
-
-    
-    virtual void update(float dt) override;
+    MenuButton(GameState* gs, const std::string& lbl, float px, float py, float w, float h, FontHandle f = FontHandle())
+        : GameObject(gs, lbl), x(px), y(py), width(w), height(h), label(lbl), font(f) {
+    }
+    bool isInside(float mx, float my) {
+        float halfW = width * 0.5f;
+        float halfH = height * 0.5f;
+        return mx >= (x - halfW) && mx <= (x + halfW) &&
+            my >= (y - halfH) && my <= (y + halfH);
+    }
     virtual void draw() override;
-
-    
-    void checkPunch(Fighter& other);
-    void resolveOverlap(Fighter& other);
 };
 
-void Fighter::update(float dt) {
-    if (anim == AnimState::KO) return;
+// Everything the main thread needs to draw a match frame, built by the
+// update job and handed over through a TripleBuffer.
+struct RenderFrame {
+    QuadList quads;
+    size_t particles = 0;
+    double particleMs = 0.0;
+};
 
-    using namespace graphics;
-    bool left = false, right = false, jump = false, punch = false;
+// The match update (ticks, effects, particles and building the next
+// RenderFrame) runs as a job on a FrameWorker, so frame N+1 is simulated
+// while the main thread draws frame N. Only the main thread calls SGG: it
+// reads the keys before starting the job and draws from the last published
+// frame. Menu handling and resetMatch() happen while the job is idle.
+class GameState {
+private:
+    // Objects live in per-type pools; this is the list update and draw walk.
+    std::vector<GameObject*> objects;
+    ObjectPool<MenuButton> buttons{ 8 };
+    AssetManager assets;
+    AnimationSet anims;
+    AnimPlayer fighterAnims;
+    std::vector<ClipId> wantedClips;
+    SpriteBatch batch;
+    TextureId menuBackground = NO_TEXTURE, arenaBackground = NO_TEXTURE;
+    TextureId preloaded = 0;
+    bool atlasBuilt = false;
+    TextId menuTitle = 0, menuHint = 0;
+    // SGG's setFont copies the path each call, so only switch when it changes.
+    FontHandle currentFont;
+    MoveTable moves;
+    float movesCheckTimer = 0.f;
+    InputSystem input;
+    ParticleSystem particles;
+    Simulation sim, prevSim;
+    // Per attacker: its current move has already landed, so the later active
+    // frames that keep hitting do not repeat the effects.
+    std::vector<uint8_t> hitLanded;
+    float accumulator = 0.f;
+    NetplaySession* netplay = nullptr;
+    AudioMixer audio;
+    AudioSink* audioSink = nullptr;
+    ReplayWriter recorder;
+    HashLogWriter hashLog;
+    std::string recordPath;
+    // Hash of sim after the last tick, written next to the replay.
+    StateHash stateHash;
+    int32_t recordedFrame = -1;   // last netplay frame written to the replay
+    bool desyncReported = false;
+    TripleBuffer<RenderFrame> frames;
+    float pendingDt = 0.f;
+    double pendingNow = 0.0;
+    // Declared last so it stops before the state its job uses is destroyed.
+    FrameWorker worker{ std::thread::hardware_concurrency() > 1 };
+
+    void update(float dt, double now);
+    // Fills the producer's RenderFrame from the current state and publishes it.
+    void buildFrame();
+    void drawFighter(QuadList& out, FighterHandle h, float alpha);
+    // Spawns particles and sounds for whatever the last tick changed: hits, jumps, landings, KOs.
+    void emitEffects();
+    // Moves the fighters' clips on by one tick, switching clip when their AnimState changed.
+    void stepAnims();
+    // Writes the netplay frames confirmed since the last call to the replay and hash log.
+    void recordConfirmed();
+    static void updateJob(void* self) {
+        GameState* gs = (GameState*)self;
+        gs->update(gs->pendingDt, gs->pendingNow);
+        gs->buildFrame();
+    }
+public:
+    ScreenState currentScreen = ScreenState::MENU;
+    bool running = true;
 
-    if (name == "Player1") {
-        left = getKeyState(SCANCODE_A);
-        right = getKeyState(SCANCODE_D);
-        jump = getKeyState(SCANCODE_W);
-        punch = getKeyState(SCANCODE_G);
+    void init();
+    // Streams the soundtrack through the mixer when it is a WAV file, otherwise hands it to SGG.
+    void startMusic();
+    // Main thread: reads input and starts stepping the match by dt on the worker.
+    void beginUpdate(float dt);
+    // Waits for the job started by beginUpdate(); the state is safe to touch after.
+    void finishUpdate() { worker.wait(); }
+    void draw();
+    TextureId loadTexture(const std::string& name) {
+        return batch.registerTexture(assets.getPath(assets.findTexture(name)));
     }
-    else {
-        left = getKeyState(SCANCODE_LEFT);
-        right = getKeyState(SCANCODE_RIGHT);
-        jump = getKeyState(SCANCODE_UP);
-        punch = getKeyState(SCANCODE_RCTRL);
+    AssetManager& getAssets() { return assets; }
+    void useFont(FontHandle f) {
+        if (!f.isValid() || f.index == currentFont.index) return;
+        graphics::setFont(assets.getPath(f));
+        currentFont = f;
+    }
+    std::vector<GameObject*>& getObjects() { return objects; }
+    // Only between finishUpdate() and the next beginUpdate().
+    Simulation& getSim() { return sim; }
+    // The frame draw() last showed.
+    const RenderFrame& getShownFrame() const { return frames.getFront(); }
+    const SpriteBatch& getBatch() const { return batch; }
+    // Fraction of a sim step elapsed since the last tick, used to interpolate drawing.
+    float getAlpha() const { return accumulator / SIM_DT; }
+    void resetMatch();
+    // Takes ownership; from then on the match is stepped through rollback.
+    void setNetplay(NetplaySession* session) { netplay = session; }
+    // Every local match is recorded to this file, replacing the previous one.
+    void setRecordPath(const std::string& path) { recordPath = path; }
+    ~GameState() {
+        worker.wait();
+        if (recorder.isOpen()) recorder.close(sim);
+        hashLog.close();
+        objects.clear();
+        delete netplay;
+        if (audioSink) audioSink->stop();
+        delete audioSink;
+#ifdef KOMBAT_SOFT_GFX
+        softSetImageSource(nullptr, nullptr);
+#endif
     }
+};
 
-    if (left) x -= speed * dt;
-    if (right) x += speed * dt;
-    if (x < 50.f) x = 50.f;
-    if (x > 750.f) x = 750.f;
+void GameState::drawFighter(QuadList& out, FighterHandle h, float alpha) {
+    const FighterStore& f = sim.getFighters();
+    const FighterStore& prev = prevSim.getFighters();
+    float x0 = toFloat(prev.x[h]), y0 = toFloat(prev.y[h]);
+    float x = x0 + (toFloat(f.x[h]) - x0) * alpha;
+    float y = y0 + (toFloat(f.y[h]) - y0) * alpha;
+    out.add(fighterAnims.getTexture(anims, h), x, GROUND_Y - y, 80.f, 110.f, 1);
+}
 
-    if (!jumping && jump) { jumping = true; vy = 300.f; }
-    if (jumping) {
-        y += vy * dt;
-        vy -= 600.f * dt;
-        if (y < 0.f) { y = 0.f; jumping = false; vy = 0.f; }
-    }
+void GameState::buildFrame() {
+    PROFILE_SCOPE("build");
+    RenderFrame& frame = frames.getBack();
+    frame.quads.clear();
+    frame.quads.add(arenaBackground, 400.f, 300.f, 800.f, 600.f);
+    float alpha = getAlpha();
+    size_t n = sim.getFighters().size();
+    for (FighterHandle h = 0; h < n; ++h)
+        drawFighter(frame.quads, h, alpha);
+    particles.draw(frame.quads, 2);
+    frame.quads.sort();
+    frame.particles = particles.getLiveCount();
+    frame.particleMs = particles.getUpdateMs();
+    frames.publish();
+}
 
-    if (punchCooldown > 0.f) {
-        punchCooldown -= dt;
-        if (punchCooldown < 0.f) punchCooldown = 0.f;
-    }
-    if (punch && punchCooldown <= 0.f) {
-        anim = AnimState::PUNCHING;
-        punchCooldown = 0.5f;
-    }
-    else if (anim != AnimState::KO && punchCooldown < 0.45f && !jumping) {
-        anim = AnimState::IDLE;
+void GameState::emitEffects() {
+    const FighterStore& before = prevSim.getFighters();
+    const FighterStore& after = sim.getFighters();
+    const MoveTable& moves = sim.getMoves();
+    for (FighterHandle h = 0; h < after.size(); ++h)
+        if (!(moves.getFrame(after.moveFrame[h]).flags & FRAME_ACTIVE)) hitLanded[h] = 0;
+    for (FighterHandle h = 0; h < after.size(); ++h) {
+        float x = toFloat(after.x[h]), y = GROUND_Y - toFloat(after.y[h]);
+        if (after.health[h] < before.health[h] && !hitLanded[h ^ 1]) {
+            float dir = after.x[h] < after.x[h ^ 1] ? -1.f : 1.f;
+            particles.hitSpark(x - dir * 20.f, y - 15.f, dir);
+            audio.play(Sfx::PUNCH);
+            hitLanded[h ^ 1] = 1;
+        }
+        if (!before.jumping[h] && after.jumping[h])
+            audio.play(Sfx::JUMP, 0.5f);
+        if (before.jumping[h] && !after.jumping[h])
+            particles.landingDust(x, y + FIGHTER_HALF_HEIGHT);
+        if (after.anim[h] == AnimState::KO && before.anim[h] != AnimState::KO) {
+            particles.koBurst(x, y);
+            audio.play(Sfx::KO);
+        }
     }
 }
 
-void Fighter::draw() {
+void GameState::stepAnims() {
+    const FighterStore& f = sim.getFighters();
+    for (FighterHandle h = 0; h < f.size(); ++h)
+        wantedClips[h] = anims.getBound(h & 1, f.anim[h]);
+    fighterAnims.step(anims, wantedClips.data(), 1);
+}
+
+void MenuButton::draw() {
     using namespace graphics;
-    std::string sprite = (anim == AnimState::KO) ? spriteKO :
-        (anim == AnimState::PUNCHING) ? spritePunch : spriteIdle;
     Brush br;
+    br.outline_opacity = 1.f;
+    br.outline_width = 2.f;
+    br.fill_color[0] = br.fill_color[1] = br.fill_color[2] = 0.2f;
+    drawRect(x, y, width, height, br);
+
+    state->useFont(font);
     br.outline_opacity = 0.f;
-    br.texture = sprite;
-    float groundY = 380.f;
-    drawRect(x, groundY - y, 80.f, 110.f, br);
+    br.fill_color[0] = br.fill_color[1] = br.fill_color[2] = 1.f;
+    drawText(x - 40.f, y + 8.f, 24.f, label, br);
 }
 
-void Fighter::checkPunch(Fighter& other) {
-    if (anim == AnimState::PUNCHING && punchCooldown > 0.45f) {
-        float dx = x - other.x;
-        if (dx < 0) dx = -dx;
-        if (dx < 60.f && other.health > 0.f) {
-            other.health -= 3.f;
-            if (other.health < 0.f) other.health = 0.f;
-            if (other.health <= 0.f) other.anim = AnimState::KO;
-        }
-    }
+#ifdef KOMBAT_SOFT_GFX
+// The software backend builds textures from the pixels the asset manager
+// already holds, and only decodes a file itself before loading has finished.
+static bool assetImage(void* user, const std::string& path, const uint8_t*& rgba, int& width, int& height) {
+    const AssetManager* assets = (const AssetManager*)user;
+    ImageView view = assets->getImage(assets->findTexturePath(path));
+    if (!view.rgba) return false;
+    rgba = view.rgba;
+    width = view.width;
+    height = view.height;
+    return true;
 }
+#endif
 
-void Fighter::resolveOverlap(Fighter& other) {
-    float r = 30.f;
-    float dx = x - other.x;
-    float dist = dx < 0 ? -dx : dx;
-    float overlap = (2 * r) - dist;
-    if (overlap > 0.f) {
-        float half = overlap * 0.5f;
-        if (dx > 0.f) { x += half; other.x -= half; }
-        else { x -= half; other.x += half; }
+void GameState::init() {
+#ifdef KOMBAT_SOFT_GFX
+    // Textures come out of the prebuilt pack when there is one, otherwise
+    // from the loose files decoded in the background.
+    softSetImageSource(assetImage, &assets);
+    if (!assets.openPack("assets.kpak", "assets")) {
+        assets.scan("assets");
+        assets.startLoading();
+    }
+#else
+    // SGG loads every texture from its file, so neither the pack's pixels
+    // nor decoding them here would be used.
+    assets.setDecodeTextures(false);
+    assets.scan("assets");
+    assets.startLoading();
+#endif
+
+    objects.push_back(buttons.spawn(this, "Play", 400.f, 250.f, 200.f, 50.f, assets.findFont("start_font")));
+
+    menuBackground = loadTexture("background");
+    arenaBackground = loadTexture("arena_bg");
+    if (!anims.load("assets/anims.txt", batch, assets, "cache/frames")) {
+        printf("using built-in animations: %s\n", anims.getError().c_str());
+        anims.useDefaults(batch, assets);
     }
-    if (x > other.x) {
-        float mid = (x + other.x) * 0.5f;
-        x = mid - r; other.x = mid + r;
+    particles.registerBrushes(batch);
+    particles.setFloor(GROUND_Y + FIGHTER_HALF_HEIGHT);
+    menuTitle = batch.registerText("MY MENU");
+    menuHint = batch.registerText("Use mouse to click the button, or ESC to quit.");
+
+    if (!moves.load("assets/moves.txt")) printf("using built-in moves: %s\n", moves.getError().c_str());
+    InputBindings keys;
+    if (!keys.load("assets/input.txt")) printf("using default keys: %s\n", keys.getError().c_str());
+    input.setBindings(keys);
+
+    // Effects without a file of their own keep the mixer's built-in ones.
+    static const char* const sfxNames[(int)Sfx::COUNT] = { "punch", "ko", "jump" };
+    for (int i = 0; i < (int)Sfx::COUNT; ++i) {
+        SoundHandle s = assets.findSound(sfxNames[i]);
+        SoundClip clip;
+        if (s.isValid() && loadWav(assets.getPath(s), clip)) audio.setClip((Sfx)i, clip);
     }
+    audioSink = createAudioSink();
+    if (!audioSink->start(audio)) {
+        printf("no sound device, mixing to a null sink\n");
+        delete audioSink;
+        audioSink = new NullAudioSink();
+        audioSink->start(audio);
+    }
+
+    resetMatch();
 }
 
+void GameState::startMusic() {
+    const std::string& path = assets.getPath(assets.findSound("soundtrack"));
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".wav") == 0) {
+        audio.setMusicVolume(0.5f);
+        if (audio.getMusic().open(path, true)) return;
+        printf("%s\n", audio.getMusic().getError().c_str());
+    }
+    graphics::playMusic(path, 0.5f, true);
+}
 
-class MenuButton : public GameObject {
-private:
-    float x, y, width, height;
-    std::string label;
-public:
-    MenuButton(GameState* gs, const std::string& lbl, float px, float py, float w, float h)
-        : GameObject(gs, lbl), x(px), y(py), width(w), height(h), label(lbl) {
+void GameState::resetMatch() {
+    // A netplay match runs from the moment both peers connect and cannot be
+    // restarted locally without desyncing.
+    if (netplay) sim = netplay->getSim();
+    else {
+        sim.setMoves(&moves);
+        sim.reset();
     }
-    bool isInside(float mx, float my) {
-        float halfW = width * 0.5f;
-        float halfH = height * 0.5f;
-        return mx >= (x - halfW) && mx <= (x + halfW) &&
-            my >= (y - halfH) && my <= (y + halfH);
+    prevSim = sim;
+    // Sized here so ticks never allocate; the first step picks each fighter's clip.
+    size_t n = sim.getFighters().size();
+    fighterAnims.resize(n);
+    wantedClips.assign(n, NO_CLIP);
+    hitLanded.assign(n, 0);
+    stepAnims();
+    input.reset();
+    particles.clear();
+    // A netplay match is recorded once, as its frames are confirmed.
+    if (!recordPath.empty() && (!netplay || (recordedFrame < 0 && !recorder.isOpen()))) {
+        recorder.open(recordPath, 0, &sim.getMoves());
+        hashLog.open(hashLogPath(recordPath));
     }
-    virtual void draw() override {
-        using namespace graphics;
-        Brush br;
-        br.outline_opacity = 1.f;
-        br.outline_width = 2.f;
-        br.fill_color[0] = br.fill_color[1] = br.fill_color[2] = 0.2f;
-        drawRect(x, y, width, height, br);
+    accumulator = 0.f;
+    buildFrame();
+}
 
-        if (label == "Play") setFont("assets\\start_font.ttf");
-        br.outline_opacity = 0.f;
-        br.fill_color[0] = br.fill_color[1] = br.fill_color[2] = 1.f;
-        drawText(x - 40.f, y + 8.f, 24.f, label.c_str(), br);
-    }
-};
+static bool keyDown(int key) {
+    return graphics::getKeyState((graphics::scancode_t)key);
+}
 
-class GameState {
-private:
-    std::vector<GameObject*> objects;
-public:
-    ScreenState currentScreen = ScreenState::MENU;
-    bool running = true;
-    std::string menuBackgroundPath = "assets\\background.png";
-    std::string arenaBackgroundPath = "assets\\arena_bg.png";
+// True on the tick the fighter's current move began, so a buffered press can be dropped.
+static bool startedMove(const Simulation& sim, FighterHandle h) {
+    const MoveFrame& fr = sim.getMoves().getFrame(sim.getFighters().moveFrame[h]);
+    return fr.move != MOVE_NONE && fr.index == 0;
+}
 
-    void init();
-    void update(float dt);
-    void draw();
-    std::vector<GameObject*>& getObjects() { return objects; }
-    Fighter* getFighter(const std::string& name) {
-        for (auto* obj : objects) {
-            Fighter* f = dynamic_cast<Fighter*>(obj);
-            if (f && f->getName() == name) return f;
-        }
-        return nullptr;
-    }
-    ~GameState() {
-        for (auto* obj : objects) delete obj;
-        objects.clear();
+void GameState::beginUpdate(float dt) {
+    worker.wait();
+    pendingDt = dt;
+    pendingNow = graphics::getGlobalTime();
+    input.poll(keyDown);
+    worker.run(updateJob, this);
+}
+
+void GameState::update(float dt, double now) {
+    // Clamp long frames so a stall does not trigger a burst of catch-up ticks.
+    if (dt > 0.25f) dt = 0.25f;
+    accumulator += dt;
+    {
+        PROFILE_SCOPE("particles");
+        particles.update(dt);
     }
-};
 
-void GameState::init() {
-    objects.push_back(new MenuButton(this, "Play", 400.f, 250.f, 200.f, 50.f));
+    if (netplay) {
+        int slot = netplay->getRollback().getLocalSlot();
+        while (accumulator >= SIM_DT) {
+            netplay->poll(now);
+            uint8_t buttons[INPUT_PLAYERS];
+            input.peekInput(buttons);
+            if (!netplay->advance(buttons[slot], now)) {
+                // Waiting on the peer; keep at most one step queued. The
+                // buttons stay out of the history until a tick takes them.
+                accumulator = SIM_DT;
+                break;
+            }
+            input.tickInput(buttons);
+            PROFILE_SCOPE("tick");
+            recordConfirmed();
+            if (netplay->getDesyncFrame() >= 0 && !desyncReported) {
+                printf("desync: peer state differs from ours at frame %d\n", netplay->getDesyncFrame());
+                desyncReported = true;
+            }
+            prevSim = sim;
+            sim = netplay->getSim();
+            if (startedMove(sim, (FighterHandle)slot)) input.moveStarted(slot);
+            emitEffects();
+            stepAnims();
+            accumulator -= SIM_DT;
+        }
+        return;
+    }
 
-    Fighter* f1 = new Fighter(this, "Player1");
-    f1->setSprites("assets\\player1_idle.png", "assets\\player1_punch.png", "assets\\player1_ko.png");
-    f1->setPosition(200.f, 0.f);
-    objects.push_back(f1);
+    // Pick up edits to the move file while the game runs, but not during a
+    // recording: its replay names one move table in its header.
+    movesCheckTimer -= dt;
+    if (movesCheckTimer <= 0.f && !recorder.isOpen()) {
+        movesCheckTimer = 0.5f;
+        if (moves.reloadIfChanged()) {
+            if (moves.getError().empty()) printf("reloaded assets/moves.txt\n");
+            else printf("%s\n", moves.getError().c_str());
+        }
+    }
 
-    Fighter* f2 = new Fighter(this, "Player2");
-    f2->setSprites("assets\\player2_idle.png", "assets\\player2_punch.png", "assets\\player2_ko.png");
-    f2->setPosition(600.f, 0.f);
-    objects.push_back(f2);
+    while (accumulator >= SIM_DT) {
+        PROFILE_SCOPE("tick");
+        ALLOC_CHECK_SCOPE("tick");
+        TickInput in;
+        input.tickInput(in.buttons);
+        prevSim = sim;
+        recorder.write(in.buttons);
+        sim.update(in, SIM_DT);
+        hashState(sim, stateHash);
+        hashLog.write(stateHash);
+        for (int p = 0; p < INPUT_PLAYERS; ++p)
+            if (startedMove(sim, (FighterHandle)p)) input.moveStarted(p);
+        emitEffects();
+        stepAnims();
+        accumulator -= SIM_DT;
+        if (recorder.isOpen() && sim.isOver()) {
+            recorder.close(sim);
+            hashLog.close();
+        }
+    }
 }
 
-void GameState::update(float dt) {
-    for (auto* obj : objects) obj->update(dt);
-    Fighter* p1 = getFighter("Player1");
-    Fighter* p2 = getFighter("Player2");
-    if (p1 && p2) {
-        if (p1->getHealth() > 0.f && p2->getHealth() > 0.f) {
-            p1->checkPunch(*p2);
-            p2->checkPunch(*p1);
+void GameState::recordConfirmed() {
+    const RollbackSession& r = netplay->getRollback();
+    while (recorder.isOpen() && recordedFrame < netplay->getHashedFrame()) {
+        int32_t f = ++recordedFrame;
+        uint8_t buttons[2] = { r.getInput(0, f), r.getInput(1, f) };
+        recorder.write(buttons);
+        hashLog.write(netplay->getHash(f));
+        const Simulation* state = r.getConfirmedState(f);
+        if (state && state->isOver()) {
+            recorder.close(*state);
+            hashLog.close();
         }
-        p1->resolveOverlap(*p2);
     }
 }
 
 void GameState::draw() {
+    PROFILE_SCOPE("draw");
     using namespace graphics;
     Brush br;
     if (currentScreen == ScreenState::MENU) {
-        if (!menuBackgroundPath.empty()) {
-            br.outline_opacity = 0.f;
-            br.texture = menuBackgroundPath;
-            drawRect(400.f, 300.f, 800.f, 600.f, br);
-        }
+        batch.add(menuBackground, 400.f, 300.f, 800.f, 600.f);
+        batch.flush();
         br.fill_color[0] = br.fill_color[1] = br.fill_color[2] = 1.f;
-        drawText(280, 100, 40, "MY MENU", br);
+        batch.drawText(menuTitle, 280, 100, 40, br);
         for (auto* obj : objects) obj->draw();
-        drawText(220, 550, 20, "Use mouse to click the button, or ESC to quit.", br);
+        batch.drawText(menuHint, 220, 550, 20, br);
+        // Warm SGG's texture cache one image per frame, so the first punch or KO does not stall.
+        if (assets.isLoaded() && preloaded < batch.getTextureCount())
+            batch.preload(preloaded++);
+        else if (assets.isLoaded() && !atlasBuilt) {
+            batch.buildAtlas();
+            atlasBuilt = true;
+        }
     }
     else if (currentScreen == ScreenState::GAME) {
-        if (!arenaBackgroundPath.empty()) {
-            br.outline_opacity = 0.f;
-            br.texture = arenaBackgroundPath;
-            drawRect(400.f, 300.f, 800.f, 600.f, br);
-        }
-        for (auto* obj : objects) {
-            
-            if (dynamic_cast<Fighter*>(obj))
-                obj->draw();
-        }
+        frames.acquire();
+        batch.draw(frames.getFront().quads);
     }
 }
 
 
 static GameState* g_gameState = nullptr;
 
+// Startup and hitch timings, printed on exit.
+static std::chrono::steady_clock::time_point g_startTime;
+static double g_startupToMenuMs = -1.0;
+static float g_firstPunchFrameMs = -1.f;
+static bool g_firstPunchShown = false;
+static double g_frameMsTotal = 0.0;
+static int g_frames = 0;
+
+#ifdef KOMBAT_PROFILE
+// Frame-time overlay, toggled with F3. Percentiles are recomputed a few
+// times a second rather than every frame.
+static bool g_showProfile = false;
+static bool g_profileKeyDown = false;
+static int g_profileRefresh = 0;
+static const char* const g_profileNames[4] = { "frame", "update", "tick", "draw" };
+// The four timers, then the particle count.
+static std::string g_profileLines[5];
+
+static void drawProfileOverlay() {
+    using namespace graphics;
+    if (g_profileRefresh-- <= 0) {
+        char line[96];
+        for (int i = 0; i < 4; ++i) {
+            ProfileStats st = profileStats(g_profileNames[i]);
+            snprintf(line, sizeof(line), "%-6s p50 %6.2f  p99 %6.2f ms", g_profileNames[i], st.p50Ms, st.p99Ms);
+            g_profileLines[i].reserve(sizeof(line));
+            g_profileLines[i].assign(line);
+        }
+        const RenderFrame& frame = g_gameState->getShownFrame();
+        snprintf(line, sizeof(line), "particles %zu  update %.2f ms", frame.particles, frame.particleMs);
+        g_profileLines[4].reserve(sizeof(line));
+        g_profileLines[4].assign(line);
+        g_profileRefresh = 15;
+    }
+    Brush br;
+    br.fill_color[0] = br.fill_color[1] = br.fill_color[2] = 0.f;
+    br.fill_opacity = 0.6f;
+    br.outline_opacity = 0.f;
+    drawRect(130.f, 62.f, 250.f, 114.f, br);
+    br.fill_color[0] = br.fill_color[1] = br.fill_color[2] = 1.f;
+    br.fill_opacity = 1.f;
+    for (int i = 0; i < 5; ++i)
+        drawText(12.f, 24.f + i * 20.f, 14.f, g_profileLines[i], br);
+}
+#endif
+
+static bool anyFighterPunching(const Simulation& sim) {
+    const FighterStore& f = sim.getFighters();
+    for (size_t i = 0; i < f.size(); ++i)
+        if (f.anim[i] == AnimState::PUNCHING) return true;
+    return false;
+}
+
 void sgg_update(float ms) {
     float dt = ms * 0.001f;
     using namespace graphics;
+    // The previous frame's match update must be done before anything below touches the state.
+    if (g_gameState) g_gameState->finishUpdate();
     if (!g_gameState || !g_gameState->running) {
         destroyWindow();
         return;
     }
+    PROFILE_RECORD("frame", profileNowNs() - (uint64_t)(ms * 1e6f), (uint64_t)(ms * 1e6f));
+    PROFILE_SCOPE("update");
+#ifdef KOMBAT_PROFILE
+    bool profileKey = getKeyState(SCANCODE_F3);
+    if (profileKey && !g_profileKeyDown) g_showProfile = !g_showProfile;
+    g_profileKeyDown = profileKey;
+#endif
     if (getKeyState(SCANCODE_ESCAPE)) {
         if (g_gameState->currentScreen == ScreenState::MENU) {
             g_gameState->currentScreen = ScreenState::EXIT;
@@ -291,28 +588,167 @@ void sgg_update(float ms) {
                 MenuButton* mb = dynamic_cast<MenuButton*>(obj);
                 if (mb && mb->isInside(mx, my) && mb->getName() == "Play") {
                     g_gameState->currentScreen = ScreenState::GAME;
-                    Fighter* p1 = g_gameState->getFighter("Player1");
-                    Fighter* p2 = g_gameState->getFighter("Player2");
-                    if (p1) { p1->setPosition(200.f, 0.f); p1->setHealth(100.f); }
-                    if (p2) { p2->setPosition(600.f, 0.f); p2->setHealth(100.f); }
+                    g_gameState->resetMatch();
                 }
             }
         }
     }
     else if (g_gameState->currentScreen == ScreenState::GAME) {
-        g_gameState->update(dt);
+        g_frameMsTotal += ms;
+        ++g_frames;
+        // The frame after a punch sprite first appears carries its load cost.
+        if (g_firstPunchShown && g_firstPunchFrameMs < 0.f) g_firstPunchFrameMs = ms;
+        if (!g_firstPunchShown && anyFighterPunching(g_gameState->getSim())) g_firstPunchShown = true;
+        g_gameState->beginUpdate(dt);
     }
     if (g_gameState->currentScreen == ScreenState::EXIT)
         g_gameState->running = false;
 }
 
 void sgg_draw() {
-    if (g_gameState && g_gameState->running)
+    if (g_gameState && g_gameState->running) {
         g_gameState->draw();
+#ifdef KOMBAT_PROFILE
+        if (g_showProfile) drawProfileOverlay();
+#endif
+        if (g_startupToMenuMs < 0.0)
+            g_startupToMenuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - g_startTime).count();
+    }
+}
+
+#ifdef KOMBAT_SOFT_GFX
+// Golden-image check: plays a scripted menu, fight and KO through the
+// software renderer, compares each scene with <dir>/<scene>.png and prints
+// what drawing it cost. A failing scene also writes <scene>.actual.png and
+// <scene>.diff.png next to the reference.
+static const int GOLDEN_TOLERANCE = 8;             // per channel
+static const int GOLDEN_FIGHT_FRAMES = 72;
+static const double GOLDEN_MAX_DIFFERING = 0.001;  // fraction of pixels
+
+// Waits for the update job before drawing, so every run draws the same frame.
+static void goldenFrame() {
+    softUpdateFrame();
+    g_gameState->finishUpdate();
+    softDrawFrame();
+}
+
+static bool goldenScene(const char* name, const std::string& dir, bool update) {
+    // Drawing leaves the state alone, so the frame is redrawn to time it.
+    double times[15];
+    for (double& t : times) {
+        softResetStats();
+        auto start = std::chrono::steady_clock::now();
+        softDrawFrame();
+        t = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::sort(times, times + 15);
+    const RasterStats& st = softGetRasterizer().getStats();
+    const SpriteBatch& batch = g_gameState->getBatch();
+
+    Image frame;
+    softGetFrame(frame);
+    std::string base = dir + "/" + name;
+    const char* result = "ok";
+    ImageDiff diff;
+    if (update) result = savePng(base + ".png", frame) ? "written" : "unwritable";
+    else {
+        Image reference;
+        if (!loadPng(base + ".png", reference)) result = "missing";
+        else {
+            diff = compareImages(frame, reference, GOLDEN_TOLERANCE);
+            if (!diff.sameSize || diff.differing > frame.rgba.size() / 4 * GOLDEN_MAX_DIFFERING) {
+                result = "FAILED";
+                Image marked;
+                diffImage(frame, reference, GOLDEN_TOLERANCE, marked);
+                savePng(base + ".actual.png", frame);
+                savePng(base + ".diff.png", marked);
+            }
+        }
+    }
+    printf("%-6s %-10s %9zu %5d %6d %6u %9llu %9llu %8.3f\n", name, result, diff.differing, diff.maxDelta,
+        batch.getDrawCalls(), st.fills, (unsigned long long)st.pixels, (unsigned long long)st.texels, times[7]);
+    return result[0] == 'o' || result[0] == 'w';
 }
 
-int main() {
+static int runGoldens(const std::string& dir, bool update) {
     using namespace graphics;
+    g_gameState->getAssets().wait();
+    printf("scene  result     differing   max  batch  fills    pixels    texels  draw ms\n");
+    bool ok = true;
+    // Long enough for the menu to have preloaded every texture.
+    for (int i = 0; i < 60; ++i) goldenFrame();
+    ok &= goldenScene("menu", dir, update);
+
+    MouseState click = {};
+    click.button_left_pressed = true;
+    click.cur_pos_x = 400;
+    click.cur_pos_y = 250;
+    softSetMouse(click);
+    goldenFrame();
+    // Both walk in, then player 1 punches until player 2 is down.
+    softSetKey(SCANCODE_D, true);
+    softSetKey(SCANCODE_LEFT, true);
+    for (int i = 0; i < GOLDEN_FIGHT_FRAMES; ++i) {
+        if (i == 40) softSetKey(SCANCODE_G, true);
+        goldenFrame();
+    }
+    ok &= goldenScene("fight", dir, update);
+
+    int frames = 0;
+    while (!g_gameState->getSim().isOver() && ++frames < 20000) goldenFrame();
+    for (int i = 0; i < 30; ++i) goldenFrame();
+    ok &= goldenScene("ko", dir, update);
+    softSetKey(SCANCODE_D, false);
+    softSetKey(SCANCODE_LEFT, false);
+    softSetKey(SCANCODE_G, false);
+    int atlasWidth = 0, atlasHeight = 0;
+    softGetAtlasSize(atlasWidth, atlasHeight);
+    printf("atlas  %dx%d, %d textures\n", atlasWidth, atlasHeight, (int)g_gameState->getBatch().getTextureCount());
+    return ok ? 0 : 1;
+}
+#endif
+
+// Kombat-Arena [--net <slot 0|1> <local port> <remote host> <remote port>] [--record <file>] [--trace <file>]
+// Software renderer builds also take [--frames <n>] [--screenshot <png>], to stop after n frames and save
+// the last one, and [--golden <dir>] [--golden-update] to check or rewrite the reference images in dir.
+int main(int argc, char** argv) {
+    using namespace graphics;
+    g_startTime = std::chrono::steady_clock::now();
+    NetplaySession* netplay = nullptr;
+    std::string recordPath, tracePath, screenshotPath, goldenDir;
+    bool goldenUpdate = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--net" && i + 4 < argc) {
+            netplay = new NetplaySession();
+            if (!netplay->start(atoi(argv[i + 1]) ? 1 : 0, (uint16_t)atoi(argv[i + 2]), argv[i + 3], (uint16_t)atoi(argv[i + 4]))) {
+                delete netplay;
+                netplay = nullptr;
+            }
+            i += 4;
+        }
+        else if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        }
+        else if (arg == "--trace" && i + 1 < argc) {
+            tracePath = argv[++i];
+        }
+#ifdef KOMBAT_SOFT_GFX
+        else if (arg == "--frames" && i + 1 < argc) {
+            softSetFrameLimit(atoi(argv[++i]));
+        }
+        else if (arg == "--screenshot" && i + 1 < argc) {
+            screenshotPath = argv[++i];
+        }
+        else if (arg == "--golden" && i + 1 < argc) {
+            goldenDir = argv[++i];
+        }
+        else if (arg == "--golden-update") {
+            goldenUpdate = true;
+        }
+#endif
+    }
+
     createWindow(800, 600, "OOP Kombat Arena");
     setUpdateFunction(sgg_update);
     setDrawFunction(sgg_draw);
@@ -328,8 +764,36 @@ int main() {
     setFont("assets\\myfont.ttf");
     g_gameState = new GameState();
     g_gameState->init();
-    playSound("assets\\soundtrack.mp3", 0.5f, true);
+    if (netplay) g_gameState->setNetplay(netplay);
+    g_gameState->setRecordPath(recordPath);
+#ifdef KOMBAT_SOFT_GFX
+    if (!goldenDir.empty()) {
+        int status = runGoldens(goldenDir, goldenUpdate);
+        delete g_gameState;
+        g_gameState = nullptr;
+        return status;
+    }
+#endif
+    AssetManager& assets = g_gameState->getAssets();
+    g_gameState->startMusic();
     startMessageLoop();
+#ifdef KOMBAT_SOFT_GFX
+    if (!screenshotPath.empty() && !softSaveFrame(screenshotPath)) printf("cannot write %s\n", screenshotPath.c_str());
+#endif
+
+    assets.wait();
+    assets.printReport();
+    printf("startup to menu: %.1f ms\n", g_startupToMenuMs);
+    if (g_frames > 0)
+        printf("first punch frame: %.1f ms (average frame %.1f ms)\n", g_firstPunchFrameMs, g_frameMsTotal / g_frames);
+#ifdef KOMBAT_PROFILE
+    for (const char* name : { "frame", "update", "tick", "draw" }) {
+        ProfileStats st = profileStats(name);
+        printf("%-6s p50 %.3f ms  p99 %.3f ms  max %.3f ms  (%d samples)\n", name, st.p50Ms, st.p99Ms, st.maxMs, st.count);
+    }
+    if (!tracePath.empty() && profileExportChromeTrace(tracePath))
+        printf("trace written to %s\n", tracePath.c_str());
+#endif
     delete g_gameState;
     g_gameState = nullptr;
     return 0;
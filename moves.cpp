@@ -0,0 +1,227 @@
+#include "moves.h"
+#include <fstream>
+#include <sstream>
+
+static MoveDef builtInPunch() {
+    // Matches the original fixed punch: a 0.5 s cooldown that lands while
+    // more than 0.45 s of it is left works out to 7 active and 54 recovery
+    // ticks at 120 Hz.
+    MoveDef punch;
+    punch.name = "punch";
+    punch.input = INPUT_PUNCH;
+    punch.active = 7;
+    punch.recovery = 54;
+    punch.hitLeft = -60.f;
+    punch.hitRight = 60.f;
+    punch.hitBottom = -1000.f;
+    punch.hitTop = 1000.f;
+    punch.damage = 3.f;
+    return punch;
+}
+
+static uint32_t fnv1a(uint32_t h, const void* data, size_t size) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < size; ++i) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+template <typename T>
+static uint32_t fnv1a(uint32_t h, const T& v) { return fnv1a(h, &v, sizeof(v)); }
+
+MoveTable::MoveTable() {
+    defs.push_back(builtInPunch());
+    compile();
+}
+
+void MoveTable::compile() {
+    frames.assign(1, MoveFrame());
+    frames[0].flags = FRAME_CANCEL;
+    firstFrame.clear();
+    for (size_t m = 0; m < defs.size(); ++m) {
+        const MoveDef& d = defs[m];
+        int total = d.startup + d.active + d.recovery;
+        firstFrame.push_back((uint16_t)frames.size());
+        for (int i = 0; i < total; ++i) {
+            MoveFrame fr;
+            fr.move = (MoveId)m;
+            fr.index = (uint16_t)i;
+            fr.next = i + 1 < total ? (uint16_t)(frames.size() + 1) : 0;
+            fr.anim = i < d.startup + d.active ? AnimState::PUNCHING : AnimState::IDLE;
+            if (i >= d.startup && i < d.startup + d.active) {
+                fr.flags |= FRAME_ACTIVE;
+                fr.damage = d.damage;
+                fr.knockback = d.knockback;
+                fr.hitLeft = d.hitLeft;
+                fr.hitRight = d.hitRight;
+                fr.hitBottom = d.hitBottom;
+                fr.hitTop = d.hitTop;
+            }
+            if (i >= d.guardFrom && i <= d.guardTo) fr.flags |= FRAME_GUARD;
+            if (i >= d.cancelFrom && i <= d.cancelTo) fr.flags |= FRAME_CANCEL;
+            frames.push_back(fr);
+        }
+    }
+
+    for (int b = 0; b < 256; ++b) {
+        startFrame[b] = 0;
+        int bestBits = 0;
+        for (size_t m = 0; m < defs.size(); ++m) {
+            uint8_t in = defs[m].input;
+            if (in == 0 || (b & in) != in) continue;
+            int bits = 0;
+            for (uint8_t v = in; v; v &= v - 1) ++bits;
+            if (bits > bestBits) { bestBits = bits; startFrame[b] = firstFrame[m]; }
+        }
+    }
+
+    hash = 2166136261u;
+    for (const MoveDef& d : defs) {
+        hash = fnv1a(hash, d.input);
+        hash = fnv1a(hash, d.startup);
+        hash = fnv1a(hash, d.active);
+        hash = fnv1a(hash, d.recovery);
+        hash = fnv1a(hash, d.hitLeft);
+        hash = fnv1a(hash, d.hitRight);
+        hash = fnv1a(hash, d.hitBottom);
+        hash = fnv1a(hash, d.hitTop);
+        hash = fnv1a(hash, d.damage);
+        hash = fnv1a(hash, d.knockback);
+        hash = fnv1a(hash, d.guardFrom);
+        hash = fnv1a(hash, d.guardTo);
+        hash = fnv1a(hash, d.cancelFrom);
+        hash = fnv1a(hash, d.cancelTo);
+    }
+}
+
+void MoveTable::setDefs(const std::vector<MoveDef>& moves) {
+    defs = moves;
+    compile();
+}
+
+void MoveTable::step(FighterStore& f, const uint8_t* buttons) const {
+    size_t n = f.size();
+    uint16_t* moveFrame = f.moveFrame.data();
+    AnimState* anim = f.anim.data();
+    const uint8_t* jumping = f.jumping.data();
+    const MoveFrame* table = frames.data();
+    size_t count = frames.size();
+
+    for (size_t i = 0; i < n; ++i) {
+        if (anim[i] == AnimState::KO) continue;
+        // Out of range only after a hot reload shrank the table.
+        uint16_t cur = moveFrame[i] < count ? table[moveFrame[i]].next : 0;
+        uint16_t start = startFrame[buttons[i]];
+        if (start && (table[cur].flags & FRAME_CANCEL)) cur = start;
+        moveFrame[i] = cur;
+        AnimState a = table[cur].anim;
+        if (a != AnimState::IDLE || !jumping[i]) anim[i] = a;
+    }
+}
+
+static bool parseInput(std::istringstream& in, uint8_t& bits) {
+    bits = 0;
+    std::string name;
+    while (in >> name) {
+        if (name == "left") bits |= INPUT_LEFT;
+        else if (name == "right") bits |= INPUT_RIGHT;
+        else if (name == "jump") bits |= INPUT_JUMP;
+        else if (name == "punch") bits |= INPUT_PUNCH;
+        else return false;
+    }
+    return bits != 0;
+}
+
+bool MoveTable::parse(const std::string& text) {
+    std::vector<MoveDef> parsed;
+    std::istringstream lines(text);
+    std::string line;
+    int lineNo = 0;
+    auto fail = [&](const char* what) {
+        error = "line " + std::to_string(lineNo) + ": " + what;
+        return false;
+    };
+
+    while (std::getline(lines, line)) {
+        ++lineNo;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.resize(hash);
+        std::istringstream in(line);
+        std::string key;
+        if (!(in >> key)) continue;
+        if (key == "move") {
+            MoveDef d;
+            if (!(in >> d.name)) return fail("move needs a name");
+            if (parsed.size() >= MOVE_NONE) return fail("too many moves");
+            parsed.push_back(d);
+            continue;
+        }
+        if (parsed.empty()) return fail("expected 'move <name>' first");
+        MoveDef& d = parsed.back();
+        bool ok;
+        if (key == "input") ok = parseInput(in, d.input);
+        else if (key == "startup") ok = (bool)(in >> d.startup) && d.startup >= 0;
+        else if (key == "active") ok = (bool)(in >> d.active) && d.active >= 0;
+        else if (key == "recovery") ok = (bool)(in >> d.recovery) && d.recovery >= 0;
+        else if (key == "hitbox") ok = (bool)(in >> d.hitLeft >> d.hitRight >> d.hitBottom >> d.hitTop);
+        else if (key == "damage") ok = (bool)(in >> d.damage);
+        else if (key == "knockback") ok = (bool)(in >> d.knockback);
+        else if (key == "guard") ok = (bool)(in >> d.guardFrom >> d.guardTo);
+        else if (key == "cancel") ok = (bool)(in >> d.cancelFrom >> d.cancelTo);
+        else return fail("unknown key");
+        if (!ok) return fail("bad value");
+    }
+    size_t frameCount = 1;
+    for (const MoveDef& d : parsed) {
+        int total = d.startup + d.active + d.recovery;
+        if (total <= 0) {
+            error = "move " + d.name + ": needs at least one frame";
+            return false;
+        }
+        frameCount += (size_t)total;
+    }
+    if (frameCount > 65535) {
+        error = "moves add up to more than 65535 frames";
+        return false;
+    }
+    setDefs(parsed);
+    error.clear();
+    return true;
+}
+
+bool MoveTable::load(const std::string& filePath) {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + filePath;
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    path = filePath;
+    std::error_code ec;
+    loadedTime = std::filesystem::last_write_time(path, ec);
+    if (!parse(text.str())) {
+        error = filePath + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+bool MoveTable::reloadIfChanged() {
+    if (path.empty()) return false;
+    std::error_code ec;
+    auto t = std::filesystem::last_write_time(path, ec);
+    if (ec || t == loadedTime) return false;
+    load(path);
+    return true;
+}
+
+MoveId MoveTable::find(const std::string& name) const {
+    for (size_t m = 0; m < defs.size(); ++m)
+        if (defs[m].name == name) return (MoveId)m;
+    return MOVE_NONE;
+}
+
+const MoveTable& defaultMoves() {
+    static const MoveTable table;
+    return table;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "sim.h"
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Data-driven moves. Each move is defined by its timing in sim ticks, a hitbox
+// and what a hit does; compile() flattens every move into one array of
+// MoveFrame that links each frame to the next. A fighter's move state is an
+// index into that array, so stepping it is a table lookup per tick.
+//
+// Move file format, one key per line, '#' starts a comment:
+//   move punch             starts a new move
+//   input punch            buttons that trigger it: left right jump punch
+//   startup 0              frames before the hitbox comes out
+//   active 7               frames the hitbox is out
+//   recovery 54            frames after that before another move can start
+//   hitbox -60 60 -1000 1000   left right bottom top, relative to the attacker
+//                              facing right; mirrored when it faces left
+//   damage 3
+//   knockback 0            pixels the target is pushed away per hit
+//   guard 0 10             frames (inclusive) during which hits are blocked
+//   cancel 7 20            frames during which another move can start (combos)
+// When several moves match the held buttons, the one needing the most buttons wins.
+// A fighter faces its opponent, or in crowd mode its nearest neighbour.
+
+typedef uint8_t MoveId;
+const MoveId MOVE_NONE = 0xff;
+
+enum MoveFrameFlags : uint8_t {
+    FRAME_ACTIVE = 1 << 0,
+    FRAME_GUARD = 1 << 1,
+    FRAME_CANCEL = 1 << 2
+};
+
+struct MoveFrame {
+    uint8_t flags = 0;
+    AnimState anim = AnimState::IDLE;
+    MoveId move = MOVE_NONE;
+    uint16_t index = 0;  // frame number within the move
+    uint16_t next = 0;   // frame after this one; 0 once the move is over
+    // Converted from the MoveDef's floats when the table is compiled.
+    Scalar damage = 0.f, knockback = 0.f;
+    Scalar hitLeft = 0.f, hitRight = 0.f, hitBottom = 0.f, hitTop = 0.f;
+};
+
+struct MoveDef {
+    std::string name;
+    uint8_t input = 0;
+    int startup = 0, active = 0, recovery = 0;
+    float hitLeft = 0.f, hitRight = 0.f, hitBottom = 0.f, hitTop = 0.f;
+    float damage = 0.f, knockback = 0.f;
+    int guardFrom = -1, guardTo = -1;
+    int cancelFrom = -1, cancelTo = -1;
+};
+
+class MoveTable {
+private:
+    std::vector<MoveDef> defs;
+    // frames[0] is the idle frame fighters rest on between moves; it allows
+    // any move to start.
+    std::vector<MoveFrame> frames;
+    std::vector<uint16_t> firstFrame;
+    uint16_t startFrame[256];
+    std::string path, error;
+    std::filesystem::file_time_type loadedTime;
+    uint32_t hash = 0;
+
+    void compile();
+public:
+    // Starts out with the built-in moves (the shipped punch).
+    MoveTable();
+
+    // Replaces the moves; false leaves the table unchanged and sets getError().
+    bool parse(const std::string& text);
+    bool load(const std::string& filePath);
+    // Re-reads the file passed to load() if it changed on disk. True when it
+    // did; getError() is empty if the new moves took effect.
+    bool reloadIfChanged();
+    void setDefs(const std::vector<MoveDef>& moves);
+
+    // Advances every fighter one frame, starting a new move if the buttons
+    // ask for one and the frame allows it, and takes the pose from the frame.
+    // Call after movement, since a move that recovers mid-air keeps its pose
+    // until the fighter lands.
+    void step(FighterStore& f, const uint8_t* buttons) const;
+
+    const std::vector<MoveDef>& getDefs() const { return defs; }
+    // FNV-1a of everything in the defs that affects the simulation (not the
+    // names), so a replay can tell whether it is played with its own moves.
+    uint32_t getHash() const { return hash; }
+    const std::string& getError() const { return error; }
+    size_t getCount() const { return defs.size(); }
+    MoveId find(const std::string& name) const;
+    // The move the held buttons start, or MOVE_NONE.
+    MoveId forInput(uint8_t buttons) const { return frames[startFrame[buttons]].move; }
+    uint16_t getFirstFrame(MoveId m) const { return firstFrame[m]; }
+    const MoveFrame& getFrame(uint16_t index) const { return frames[index]; }
+};
+
+// Shared instance of the built-in moves, used when a simulation has none set.
+const MoveTable& defaultMoves();
@@ -0,0 +1,150 @@
+#include "net.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif
+typedef int socklen_t;
+typedef SOCKET NativeSocket;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int NativeSocket;
+#endif
+
+static bool initSockets() {
+#ifdef _WIN32
+    static bool started = false;
+    if (!started) {
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0) return false;
+        started = true;
+    }
+#endif
+    return true;
+}
+
+bool resolveAddress(const char* host, uint16_t port, NetAddress& out) {
+    if (!initSockets()) return false;
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &result) != 0 || !result) return false;
+    sockaddr_in* sa = (sockaddr_in*)result->ai_addr;
+    out.ip = ntohl(sa->sin_addr.s_addr);
+    out.port = port;
+    freeaddrinfo(result);
+    return true;
+}
+
+bool UdpSocket::open(uint16_t port) {
+    close();
+    if (!initSockets()) return false;
+    NativeSocket s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#ifdef _WIN32
+    if (s == INVALID_SOCKET) return false;
+    u_long nonBlocking = 1;
+    ioctlsocket(s, FIONBIO, &nonBlocking);
+#else
+    if (s < 0) return false;
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    handle = (intptr_t)s;
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(s, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void UdpSocket::close() {
+    if (handle == -1) return;
+#ifdef _WIN32
+    closesocket((NativeSocket)handle);
+#else
+    ::close((NativeSocket)handle);
+#endif
+    handle = -1;
+}
+
+bool UdpSocket::sendTo(const NetAddress& to, const void* data, int size) {
+    if (handle == -1) return false;
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(to.ip);
+    addr.sin_port = htons(to.port);
+    return sendto((NativeSocket)handle, (const char*)data, size, 0, (sockaddr*)&addr, sizeof(addr)) == size;
+}
+
+int UdpSocket::receive(void* buffer, int capacity, NetAddress* from) {
+    if (handle == -1) return -1;
+    sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int n = (int)recvfrom((NativeSocket)handle, (char*)buffer, capacity, 0, (sockaddr*)&addr, &len);
+    if (n < 0) return -1;
+    if (from) {
+        from->ip = ntohl(addr.sin_addr.s_addr);
+        from->port = ntohs(addr.sin_port);
+    }
+    return n;
+}
+
+bool UdpLink::open(uint16_t localPort, const NetAddress& remote) {
+    peer = remote;
+    queue.clear();
+    return socket.open(localPort);
+}
+
+void UdpLink::setConditions(double latency, int loss, uint32_t seed) {
+    latencyMs = latency;
+    lossPercent = loss;
+    rng = seed ? seed : 1u;
+}
+
+void UdpLink::send(const void* data, int size, double nowMs) {
+    ++sent;
+    if (lossPercent > 0) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        if ((int)(rng % 100) < lossPercent) { ++dropped; return; }
+    }
+    if (latencyMs <= 0.0) {
+        socket.sendTo(peer, data, size);
+        return;
+    }
+    const uint8_t* bytes = (const uint8_t*)data;
+    queue.push_back({ nowMs + latencyMs, std::vector<uint8_t>(bytes, bytes + size) });
+}
+
+int UdpLink::receive(void* buffer, int capacity) {
+    NetAddress from;
+    for (;;) {
+        int n = socket.receive(buffer, capacity, &from);
+        if (n < 0) return -1;
+        if (from == peer) return n;
+    }
+}
+
+void UdpLink::flush(double nowMs) {
+    while (!queue.empty() && queue.front().deliverAt <= nowMs) {
+        socket.sendTo(peer, queue.front().data.data(), (int)queue.front().data.size());
+        queue.pop_front();
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Minimal non-blocking UDP transport for netplay, plus a shim that delays and
+// drops outgoing packets to test rollback under bad conditions.
+
+struct NetAddress {
+    uint32_t ip = 0;     // host byte order
+    uint16_t port = 0;
+    bool operator==(const NetAddress& o) const { return ip == o.ip && port == o.port; }
+};
+
+bool resolveAddress(const char* host, uint16_t port, NetAddress& out);
+
+class UdpSocket {
+private:
+    intptr_t handle = -1;
+public:
+    ~UdpSocket() { close(); }
+
+    bool open(uint16_t port);
+    void close();
+    bool isOpen() const { return handle != -1; }
+    bool sendTo(const NetAddress& to, const void* data, int size);
+    // Returns the number of bytes received, or -1 when nothing is pending.
+    int receive(void* buffer, int capacity, NetAddress* from);
+};
+
+// A socket bound to one peer. When latency or loss is set, outgoing packets
+// are queued and released by flush() once their delivery time has passed.
+class UdpLink {
+private:
+    struct Pending {
+        double deliverAt;
+        std::vector<uint8_t> data;
+    };
+    UdpSocket socket;
+    NetAddress peer;
+    std::deque<Pending> queue;
+    double latencyMs = 0.0;
+    int lossPercent = 0;
+    uint32_t rng = 0x9e3779b9u;
+    int sent = 0, dropped = 0;
+public:
+    bool open(uint16_t localPort, const NetAddress& remote);
+    void setConditions(double latency, int loss, uint32_t seed);
+    void send(const void* data, int size, double nowMs);
+    int receive(void* buffer, int capacity);
+    void flush(double nowMs);
+    int getSentPackets() const { return sent; }
+    int getDroppedPackets() const { return dropped; }
+};
@@ -0,0 +1,130 @@
+#include "pack.h"
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(f, &fileSize) || fileSize.QuadPart == 0) { CloseHandle(f); return false; }
+    HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m) { CloseHandle(f); return false; }
+    void* view = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    if (!view) { CloseHandle(m); CloseHandle(f); return false; }
+    fileHandle = f;
+    mapping = m;
+    data = (const uint8_t*)view;
+    size = (size_t)fileSize.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return false; }
+    void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) return false;
+    data = (const uint8_t*)view;
+    size = (size_t)st.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if (!data) return;
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE)mapping);
+    CloseHandle((HANDLE)fileHandle);
+    mapping = fileHandle = nullptr;
+#else
+    munmap((void*)data, size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+bool PackFile::open(const std::string& path) {
+    close();
+    if (!file.open(path)) return false;
+    const uint8_t* base = file.getData();
+    size_t size = file.getSize();
+    if (size < sizeof(PackHeader)) { close(); return false; }
+    const PackHeader* header = (const PackHeader*)base;
+    if (memcmp(header->magic, "KPAK", 4) != 0 || header->version != PACK_VERSION ||
+        sizeof(PackHeader) + (size_t)header->count * sizeof(PackEntry) > size) {
+        close();
+        return false;
+    }
+    const PackEntry* index = (const PackEntry*)(base + sizeof(PackHeader));
+    for (uint32_t i = 0; i < header->count; ++i) {
+        const PackEntry& e = index[i];
+        bool ok = e.offset <= size && e.size <= size - e.offset && e.fileName[sizeof(e.fileName) - 1] == 0;
+        // Decoded images must hold width * height texels, compared without
+        // forming the product, which can overflow.
+        if (e.format == (uint8_t)PackFormat::RGBA8)
+            ok = ok && e.width > 0 && e.height > 0 && e.width <= INT32_MAX && e.height <= INT32_MAX &&
+                e.height <= e.size / 4 / e.width;
+        if (!ok) {
+            close();
+            return false;
+        }
+    }
+    entries = index;
+    count = header->count;
+    return true;
+}
+
+static uint64_t alignUp(uint64_t v) {
+    return (v + PACK_ALIGNMENT - 1) & ~(uint64_t)(PACK_ALIGNMENT - 1);
+}
+
+bool writePack(const std::string& path, const std::vector<PackInput>& inputs) {
+    std::vector<PackEntry> index(inputs.size());
+    uint64_t offset = alignUp(sizeof(PackHeader) + inputs.size() * sizeof(PackEntry));
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        const PackInput& in = inputs[i];
+        PackEntry& e = index[i];
+        memset(&e, 0, sizeof(e));
+        if (in.fileName.size() >= sizeof(e.fileName)) return false;
+        memcpy(e.fileName, in.fileName.c_str(), in.fileName.size());
+        e.type = in.type;
+        e.format = (uint8_t)in.format;
+        e.width = in.width;
+        e.height = in.height;
+        e.offset = offset;
+        e.size = in.size;
+        offset = alignUp(offset + in.size);
+    }
+
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    PackHeader header;
+    memcpy(header.magic, "KPAK", 4);
+    header.version = PACK_VERSION;
+    header.count = (uint32_t)inputs.size();
+    header.reserved = 0;
+    fwrite(&header, sizeof(header), 1, f);
+    if (!index.empty()) fwrite(index.data(), sizeof(PackEntry), index.size(), f);
+
+    static const uint8_t zeros[PACK_ALIGNMENT] = {};
+    uint64_t written = sizeof(PackHeader) + index.size() * sizeof(PackEntry);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        fwrite(zeros, 1, (size_t)(index[i].offset - written), f);
+        fwrite(inputs[i].data, 1, inputs[i].size, f);
+        written = index[i].offset + inputs[i].size;
+    }
+    bool ok = ferror(f) == 0;
+    fclose(f);
+    return ok;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Single-file asset pack produced offline by the packer tool. Images are
+// stored already decoded as RGBA8, sounds as an entry with no data (they are
+// played from their files), everything else as the original bytes.
+// The file is memory-mapped and entries are handed out as pointers into the
+// mapping, so opening a pack costs one map call and no copies.
+//
+// Layout (little-endian, matching the in-memory structs on the platforms we
+// ship): PackHeader, then PackHeader::count PackEntry records, then the
+// entry data, each blob aligned to PACK_ALIGNMENT.
+
+const uint32_t PACK_VERSION = 1;
+const uint32_t PACK_ALIGNMENT = 64;
+
+enum class PackFormat : uint8_t { RAW, RGBA8 };
+
+struct PackHeader {
+    char magic[4];        // "KPAK"
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct PackEntry {
+    char fileName[36];    // original file name, zero-terminated
+    uint8_t type;         // AssetType
+    uint8_t format;       // PackFormat
+    uint16_t reserved;
+    uint32_t width, height;
+    uint64_t offset, size;
+};
+
+static_assert(sizeof(PackHeader) == 16, "pack header layout");
+static_assert(sizeof(PackEntry) == 64, "pack entry layout");
+
+class MappedFile {
+private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mapping = nullptr;
+#endif
+public:
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path);
+    void close();
+    const uint8_t* getData() const { return data; }
+    size_t getSize() const { return size; }
+};
+
+class PackFile {
+private:
+    MappedFile file;
+    const PackEntry* entries = nullptr;
+    uint32_t count = 0;
+public:
+    bool open(const std::string& path);
+    void close() { file.close(); entries = nullptr; count = 0; }
+    uint32_t getCount() const { return count; }
+    const PackEntry& getEntry(uint32_t i) const { return entries[i]; }
+    const uint8_t* getData(uint32_t i) const { return file.getData() + entries[i].offset; }
+};
+
+struct PackInput {
+    std::string fileName;
+    uint8_t type;
+    PackFormat format;
+    uint32_t width, height;
+    const uint8_t* data;
+    size_t size;
+};
+
+bool writePack(const std::string& path, const std::vector<PackInput>& inputs);
@@ -0,0 +1,121 @@
+#include "particles.h"
+#include "simd.h"
+#include <chrono>
+#include <cmath>
+
+static const float PARTICLE_GRAVITY = 900.f;
+// On hitting the floor: vertical speed is reversed and scaled, horizontal scaled.
+static const float PARTICLE_BOUNCE = -0.35f;
+static const float PARTICLE_FRICTION = 0.6f;
+
+ParticleSystem::ParticleSystem(size_t maxParticles)
+    : x(maxParticles), y(maxParticles), vx(maxParticles), vy(maxParticles),
+      life(maxParticles), size(maxParticles), kind(maxParticles), capacity(maxParticles), rng(0x5eed) {
+    for (TextureId& b : brushes) b = NO_TEXTURE;
+}
+
+void ParticleSystem::registerBrushes(SpriteBatch& batch) {
+    brushes[(int)ParticleKind::SPARK] = batch.registerColor(1.f, 0.85f, 0.3f);
+    brushes[(int)ParticleKind::DUST] = batch.registerColor(0.6f, 0.55f, 0.5f);
+    brushes[(int)ParticleKind::KO] = batch.registerColor(0.9f, 0.15f, 0.1f);
+}
+
+float ParticleSystem::random(float lo, float hi) {
+    return lo + (hi - lo) * (float)(rng.next() >> 8) * (1.f / 16777216.f);
+}
+
+// Dropped when the pool is full: effects are cosmetic.
+void ParticleSystem::spawn(ParticleKind k, float px, float py, float pvx, float pvy, float plife, float psize) {
+    if (live == capacity) return;
+    size_t i = live++;
+    x[i] = px;
+    y[i] = py;
+    vx[i] = pvx;
+    vy[i] = pvy;
+    life[i] = plife;
+    size[i] = psize;
+    kind[i] = k;
+}
+
+void ParticleSystem::hitSpark(float px, float py, float dir) {
+    for (int i = 0; i < 12; ++i)
+        spawn(ParticleKind::SPARK, px, py, dir * random(80.f, 420.f), random(-380.f, 60.f), random(0.2f, 0.45f), random(4.f, 8.f));
+}
+
+void ParticleSystem::landingDust(float px, float py) {
+    for (int i = 0; i < 10; ++i) {
+        float side = i & 1 ? 1.f : -1.f;
+        spawn(ParticleKind::DUST, px + side * random(0.f, 20.f), py, side * random(40.f, 160.f), random(-120.f, -20.f), random(0.3f, 0.6f), random(6.f, 12.f));
+    }
+}
+
+void ParticleSystem::koBurst(float px, float py) {
+    for (int i = 0; i < 150; ++i) {
+        float a = random(0.f, 6.2831853f), speed = random(100.f, 600.f);
+        spawn(ParticleKind::KO, px, py, speed * std::cos(a), speed * std::sin(a), random(0.6f, 1.2f), random(5.f, 10.f));
+    }
+}
+
+void ParticleSystem::update(float dt) {
+    auto start = std::chrono::steady_clock::now();
+    float* px = x.data();
+    float* py = y.data();
+    float* pvx = vx.data();
+    float* pvy = vy.data();
+    float* plife = life.data();
+    size_t n = live, i = 0;
+#if KOMBAT_SIMD
+    const __m128 g = _mm_set1_ps(PARTICLE_GRAVITY * dt), step = _mm_set1_ps(dt), floor = _mm_set1_ps(floorY);
+    const __m128 bounce = _mm_set1_ps(PARTICLE_BOUNCE), friction = _mm_set1_ps(PARTICLE_FRICTION);
+    for (; i + 4 <= n; i += 4) {
+        __m128 vyi = _mm_add_ps(_mm_loadu_ps(pvy + i), g), vxi = _mm_loadu_ps(pvx + i);
+        __m128 xi = _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(vxi, step));
+        __m128 yi = _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(vyi, step));
+        __m128 below = _mm_cmpgt_ps(yi, floor);
+        _mm_storeu_ps(px + i, xi);
+        _mm_storeu_ps(py + i, simdSelect(below, floor, yi));
+        _mm_storeu_ps(pvy + i, simdSelect(below, _mm_mul_ps(vyi, bounce), vyi));
+        _mm_storeu_ps(pvx + i, simdSelect(below, _mm_mul_ps(vxi, friction), vxi));
+        _mm_storeu_ps(plife + i, _mm_sub_ps(_mm_loadu_ps(plife + i), step));
+    }
+#endif
+    for (; i < n; ++i) {
+        pvy[i] += PARTICLE_GRAVITY * dt;
+        px[i] += pvx[i] * dt;
+        py[i] += pvy[i] * dt;
+        if (py[i] > floorY) {
+            py[i] = floorY;
+            pvy[i] *= PARTICLE_BOUNCE;
+            pvx[i] *= PARTICLE_FRICTION;
+        }
+        plife[i] -= dt;
+    }
+
+    // Keep the live ones packed: a dead particle takes the last live one's slot.
+    for (i = 0; i < n;) {
+        if (plife[i] > 0.f) { ++i; continue; }
+        --n;
+        px[i] = px[n];
+        py[i] = py[n];
+        pvx[i] = pvx[n];
+        pvy[i] = pvy[n];
+        plife[i] = plife[n];
+        size[i] = size[n];
+        kind[i] = kind[n];
+    }
+    live = n;
+    updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ParticleSystem::draw(QuadList& out, uint8_t layer) const {
+    for (int k = 0; k < (int)ParticleKind::COUNT; ++k) {
+        TextureId brush = brushes[k];
+        if (brush == NO_TEXTURE) continue;
+        for (size_t i = 0; i < live; ++i) {
+            if (kind[i] != (ParticleKind)k) continue;
+            // Shrink away over the last quarter second.
+            float s = life[i] < 0.25f ? size[i] * life[i] * 4.f : size[i];
+            out.add(brush, x[i], y[i], s, s, layer);
+        }
+    }
+}
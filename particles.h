@@ -0,0 +1,52 @@
+#pragma once
+#include "bot.h"
+#include "spritebatch.h"
+#include <cstdint>
+#include <vector>
+
+// Purely visual particles (hit sparks, landing dust, KO bursts) in canvas
+// units, y pointing down. Each attribute is its own array with a fixed
+// capacity allocated up front; live particles are packed at the front, so
+// the update is one SIMD pass over contiguous floats and a dead particle is
+// replaced by the last live one. Drawing adds them to a QuadList as one run
+// of quads per kind, so each kind costs a single brush.
+//
+// Particles are not part of the simulation: they are spawned by the game from
+// what changed between ticks and stepped once per rendered frame.
+
+enum class ParticleKind : uint8_t { SPARK, DUST, KO, COUNT };
+
+class ParticleSystem {
+private:
+    std::vector<float> x, y, vx, vy, life, size;
+    std::vector<ParticleKind> kind;
+    size_t live = 0, capacity;
+    TextureId brushes[(int)ParticleKind::COUNT];
+    float floorY = 1e9f;
+    Rng rng;
+    double updateMs = 0.0;
+
+    float random(float lo, float hi);
+    void spawn(ParticleKind k, float px, float py, float pvx, float pvy, float plife, float psize);
+public:
+    explicit ParticleSystem(size_t maxParticles = 65536);
+
+    // Registers one solid-colour brush per kind with the batch.
+    void registerBrushes(SpriteBatch& batch);
+    // Particles bounce off this canvas y.
+    void setFloor(float y) { floorY = y; }
+    void clear() { live = 0; }
+
+    // dir is -1 or 1, the way the hit pushes.
+    void hitSpark(float px, float py, float dir);
+    void landingDust(float px, float py);
+    void koBurst(float px, float py);
+
+    void update(float dt);
+    void draw(QuadList& out, uint8_t layer) const;
+
+    size_t getLiveCount() const { return live; }
+    size_t getCapacity() const { return capacity; }
+    // Wall time of the last update() call.
+    double getUpdateMs() const { return updateMs; }
+};
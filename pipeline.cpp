@@ -0,0 +1,49 @@
+#include "pipeline.h"
+
+FrameWorker::FrameWorker(bool threaded) {
+    if (threaded) thread = std::thread(&FrameWorker::loop, this);
+}
+
+FrameWorker::~FrameWorker() {
+    if (!thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        quit = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void FrameWorker::loop() {
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;) {
+        wake.wait(guard, [this] { return busy || quit; });
+        // Finish a job handed over before quit was set.
+        if (!busy) return;
+        guard.unlock();
+        job(arg);
+        guard.lock();
+        busy = false;
+        done.notify_all();
+    }
+}
+
+void FrameWorker::run(void (*fn)(void*), void* jobArg) {
+    if (!thread.joinable()) {
+        fn(jobArg);
+        return;
+    }
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait(guard, [this] { return !busy; });
+    job = fn;
+    arg = jobArg;
+    busy = true;
+    guard.unlock();
+    wake.notify_one();
+}
+
+void FrameWorker::wait() {
+    if (!thread.joinable()) return;
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait(guard, [this] { return !busy; });
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Hands whole frames from a producer thread to a consumer without locks or
+// waiting. There are three buffers: the producer fills its back buffer and
+// publish() swaps it with the shared middle one; acquire() swaps the middle
+// with the consumer's front buffer if something new was published. Each
+// side only ever touches the buffer it holds, and a slow consumer just skips
+// frames.
+template <typename T>
+class TripleBuffer {
+private:
+    static const uint8_t FRESH = 4;  // set on the middle index when it holds an unread frame
+    T buffers[3];
+    std::atomic<uint8_t> middle{ 1 };
+    uint8_t back = 0, front = 2;
+public:
+    // Producer side.
+    T& getBack() { return buffers[back]; }
+    void publish() { back = middle.exchange((uint8_t)(back | FRESH), std::memory_order_acq_rel) & 3; }
+
+    // Consumer side. True if front now holds a newer frame.
+    bool acquire() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & 3;
+        return true;
+    }
+    const T& getFront() const { return buffers[front]; }
+};
+
+// Runs one job at a time on its own thread: run() hands the job over and
+// returns at once, wait() blocks until it has finished. Without a thread
+// (single-core machines) run() does the job itself. Jobs are a plain
+// function pointer and argument so handing one over never allocates.
+class FrameWorker {
+private:
+    std::thread thread;
+    std::mutex lock;
+    std::condition_variable wake, done;
+    void (*job)(void*) = nullptr;
+    void* arg = nullptr;
+    bool busy = false, quit = false;
+
+    void loop();
+public:
+    explicit FrameWorker(bool threaded);
+    ~FrameWorker();
+    FrameWorker(const FrameWorker&) = delete;
+    FrameWorker& operator=(const FrameWorker&) = delete;
+
+    // Waits for the previous job first.
+    void run(void (*fn)(void*), void* jobArg);
+    void wait();
+    bool isThreaded() const { return thread.joinable(); }
+};
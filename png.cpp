@@ -0,0 +1,490 @@
+#include "png.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+struct BitReader {
+    const uint8_t* data;
+    size_t size, pos = 0;
+    uint32_t bits = 0;
+    int count = 0;
+
+    BitReader(const uint8_t* d, size_t s) : data(d), size(s) {}
+    bool need(int n) {
+        while (count < n) {
+            if (pos >= size) return false;
+            bits |= (uint32_t)data[pos++] << count;
+            count += 8;
+        }
+        return true;
+    }
+    int get(int n) {
+        if (!need(n)) return -1;
+        int v = (int)(bits & ((1u << n) - 1));
+        bits >>= n;
+        count -= n;
+        return v;
+    }
+    void alignToByte() { bits = 0; count = 0; }
+};
+
+// Canonical Huffman table decoded one bit at a time, as in zlib's puff.c.
+struct Huffman {
+    uint16_t counts[16];
+    uint16_t symbols[288];
+
+    bool build(const uint8_t* lengths, int n) {
+        memset(counts, 0, sizeof(counts));
+        for (int i = 0; i < n; ++i) counts[lengths[i]]++;
+        counts[0] = 0;
+        uint16_t offsets[16];
+        offsets[1] = 0;
+        for (int len = 1; len < 15; ++len) offsets[len + 1] = offsets[len] + counts[len];
+        for (int i = 0; i < n; ++i)
+            if (lengths[i]) symbols[offsets[lengths[i]]++] = (uint16_t)i;
+        return true;
+    }
+    int decode(BitReader& in) const {
+        int code = 0, first = 0, index = 0;
+        for (int len = 1; len < 16; ++len) {
+            int b = in.get(1);
+            if (b < 0) return -1;
+            code |= b;
+            int count = counts[len];
+            if (code - count < first) return symbols[index + (code - first)];
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+};
+
+const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const uint16_t distBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+const uint8_t distExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+bool inflateBlock(BitReader& in, std::vector<uint8_t>& out, const Huffman& lit, const Huffman& dist) {
+    for (;;) {
+        int sym = lit.decode(in);
+        if (sym < 0) return false;
+        if (sym < 256) { out.push_back((uint8_t)sym); continue; }
+        if (sym == 256) return true;
+        sym -= 257;
+        if (sym >= 29) return false;
+        int extra = in.get(lengthExtra[sym]);
+        if (extra < 0) return false;
+        int len = lengthBase[sym] + extra;
+        int dsym = dist.decode(in);
+        if (dsym < 0 || dsym >= 30) return false;
+        extra = in.get(distExtra[dsym]);
+        if (extra < 0) return false;
+        size_t d = distBase[dsym] + extra;
+        if (d > out.size()) return false;
+        size_t from = out.size() - d;
+        for (int i = 0; i < len; ++i) out.push_back(out[from + i]);
+    }
+}
+
+bool inflateDynamic(BitReader& in, std::vector<uint8_t>& out) {
+    static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    int nlen = in.get(5), ndist = in.get(5), ncode = in.get(4);
+    if (nlen < 0 || ndist < 0 || ncode < 0) return false;
+    nlen += 257; ndist += 1; ncode += 4;
+    if (nlen > 286 || ndist > 30) return false;
+
+    uint8_t lengths[320] = {};
+    for (int i = 0; i < ncode; ++i) {
+        int v = in.get(3);
+        if (v < 0) return false;
+        lengths[order[i]] = (uint8_t)v;
+    }
+    Huffman codes;
+    codes.build(lengths, 19);
+
+    memset(lengths, 0, sizeof(lengths));
+    int i = 0;
+    while (i < nlen + ndist) {
+        int sym = codes.decode(in);
+        if (sym < 0) return false;
+        if (sym < 16) { lengths[i++] = (uint8_t)sym; continue; }
+        int repeat, value = 0;
+        if (sym == 16) {
+            if (i == 0) return false;
+            value = lengths[i - 1];
+            repeat = 3 + in.get(2);
+        }
+        else if (sym == 17) repeat = 3 + in.get(3);
+        else repeat = 11 + in.get(7);
+        if (repeat < 3 || i + repeat > nlen + ndist) return false;
+        while (repeat--) lengths[i++] = (uint8_t)value;
+    }
+    Huffman lit, dist;
+    lit.build(lengths, nlen);
+    dist.build(lengths + nlen, ndist);
+    return inflateBlock(in, out, lit, dist);
+}
+
+bool inflateFixed(BitReader& in, std::vector<uint8_t>& out) {
+    static Huffman lit, dist;
+    static bool built = false;
+    if (!built) {
+        uint8_t lengths[288];
+        int i = 0;
+        for (; i < 144; ++i) lengths[i] = 8;
+        for (; i < 256; ++i) lengths[i] = 9;
+        for (; i < 280; ++i) lengths[i] = 7;
+        for (; i < 288; ++i) lengths[i] = 8;
+        lit.build(lengths, 288);
+        for (i = 0; i < 30; ++i) lengths[i] = 5;
+        dist.build(lengths, 30);
+        built = true;
+    }
+    return inflateBlock(in, out, lit, dist);
+}
+
+uint32_t readBE32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+int paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = p > a ? p - a : a - p;
+    int pb = p > b ? p - b : b - p;
+    int pc = p > c ? p - c : c - p;
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+}
+
+bool inflateZlib(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    if (size < 2 || (data[0] & 0x0f) != 8 || ((data[0] << 8) | data[1]) % 31 != 0) return false;
+    BitReader in(data + 2, size - 2);
+    int last;
+    do {
+        last = in.get(1);
+        int type = in.get(2);
+        if (last < 0 || type < 0) return false;
+        if (type == 0) {
+            in.alignToByte();
+            if (in.pos + 4 > in.size) return false;
+            size_t len = in.data[in.pos] | (in.data[in.pos + 1] << 8);
+            in.pos += 4;
+            if (in.pos + len > in.size) return false;
+            out.insert(out.end(), in.data + in.pos, in.data + in.pos + len);
+            in.pos += len;
+        }
+        else if (type == 1) {
+            if (!inflateFixed(in, out)) return false;
+        }
+        else if (type == 2) {
+            if (!inflateDynamic(in, out)) return false;
+        }
+        else return false;
+    } while (!last);
+    return true;
+}
+
+bool decodePng(const uint8_t* data, size_t size, Image& out) {
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    if (size < 8 || memcmp(data, signature, 8) != 0) return false;
+
+    int width = 0, height = 0, depth = 0, colorType = 0, interlace = 0;
+    std::vector<uint8_t> compressed, palette, paletteAlpha;
+    size_t pos = 8;
+    while (pos + 12 <= size) {
+        uint32_t len = readBE32(data + pos);
+        const uint8_t* type = data + pos + 4;
+        const uint8_t* body = data + pos + 8;
+        if (pos + 12 + len > size) return false;
+        if (memcmp(type, "IHDR", 4) == 0 && len >= 13) {
+            width = (int)readBE32(body);
+            height = (int)readBE32(body + 4);
+            depth = body[8];
+            colorType = body[9];
+            interlace = body[12];
+        }
+        else if (memcmp(type, "PLTE", 4) == 0) palette.assign(body, body + len);
+        else if (memcmp(type, "tRNS", 4) == 0) paletteAlpha.assign(body, body + len);
+        else if (memcmp(type, "IDAT", 4) == 0) compressed.insert(compressed.end(), body, body + len);
+        else if (memcmp(type, "IEND", 4) == 0) break;
+        pos += 12 + len;
+    }
+    if (width <= 0 || height <= 0 || depth != 8 || interlace != 0) return false;
+
+    int channels;
+    switch (colorType) {
+    case 0: channels = 1; break;
+    case 2: channels = 3; break;
+    case 3: channels = 1; break;
+    case 4: channels = 2; break;
+    case 6: channels = 4; break;
+    default: return false;
+    }
+
+    std::vector<uint8_t> raw;
+    raw.reserve((size_t)(width * channels + 1) * height);
+    if (!inflateZlib(compressed.data(), compressed.size(), raw)) return false;
+    size_t stride = (size_t)width * channels;
+    if (raw.size() < (stride + 1) * height) return false;
+
+    // Undo the per-scanline filters in place.
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = &raw[y * (stride + 1) + 1];
+        const uint8_t* prior = y > 0 ? &raw[(y - 1) * (stride + 1) + 1] : nullptr;
+        int filter = row[-1];
+        for (size_t i = 0; i < stride; ++i) {
+            int a = i >= (size_t)channels ? row[i - channels] : 0;
+            int b = prior ? prior[i] : 0;
+            int c = (prior && i >= (size_t)channels) ? prior[i - channels] : 0;
+            switch (filter) {
+            case 0: break;
+            case 1: row[i] = (uint8_t)(row[i] + a); break;
+            case 2: row[i] = (uint8_t)(row[i] + b); break;
+            case 3: row[i] = (uint8_t)(row[i] + ((a + b) >> 1)); break;
+            case 4: row[i] = (uint8_t)(row[i] + paeth(a, b, c)); break;
+            default: return false;
+            }
+        }
+    }
+
+    out.width = width;
+    out.height = height;
+    out.rgba.resize((size_t)width * height * 4);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* src = &raw[y * (stride + 1) + 1];
+        uint8_t* dst = &out.rgba[(size_t)y * width * 4];
+        for (int x = 0; x < width; ++x, dst += 4) {
+            switch (colorType) {
+            case 0: dst[0] = dst[1] = dst[2] = src[x]; dst[3] = 255; break;
+            case 2: memcpy(dst, src + x * 3, 3); dst[3] = 255; break;
+            case 3: {
+                size_t i = src[x];
+                if (i * 3 + 2 >= palette.size()) return false;
+                memcpy(dst, &palette[i * 3], 3);
+                dst[3] = i < paletteAlpha.size() ? paletteAlpha[i] : 255;
+                break;
+            }
+            case 4: dst[0] = dst[1] = dst[2] = src[x * 2]; dst[3] = src[x * 2 + 1]; break;
+            case 6: memcpy(dst, src + x * 4, 4); break;
+            }
+        }
+    }
+    return true;
+}
+
+namespace {
+
+struct BitWriter {
+    std::vector<uint8_t>& out;
+    uint32_t bits = 0;
+    int count = 0;
+
+    explicit BitWriter(std::vector<uint8_t>& o) : out(o) {}
+    void put(uint32_t v, int n) {
+        bits |= v << count;
+        count += n;
+        while (count >= 8) {
+            out.push_back((uint8_t)bits);
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+    // Huffman codes go most significant bit first.
+    void putCode(uint32_t code, int n) {
+        uint32_t r = 0;
+        for (int i = 0; i < n; ++i) r |= ((code >> i) & 1) << (n - 1 - i);
+        put(r, n);
+    }
+    void flush() {
+        if (count > 0) out.push_back((uint8_t)bits);
+        bits = 0;
+        count = 0;
+    }
+};
+
+// A literal or length symbol with the fixed Huffman code of RFC 1951 3.2.6.
+void putFixedSymbol(BitWriter& w, int sym) {
+    if (sym < 144) w.putCode(0x30 + sym, 8);
+    else if (sym < 256) w.putCode(0x190 + sym - 144, 9);
+    else if (sym < 280) w.putCode(sym - 256, 7);
+    else w.putCode(0xc0 + sym - 280, 8);
+}
+
+void putMatch(BitWriter& w, int length, int distance) {
+    int l = 28;
+    while (lengthBase[l] > length) --l;
+    putFixedSymbol(w, 257 + l);
+    w.put(length - lengthBase[l], lengthExtra[l]);
+    int d = 29;
+    while (distBase[d] > distance) --d;
+    w.putCode(d, 5);
+    w.put(distance - distBase[d], distExtra[d]);
+}
+
+// One fixed-Huffman block with greedy LZ77 matching over hash chains.
+// Nowhere near zlib's ratio, but screenshots and sprite cells shrink a lot.
+void deflateFixed(const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+    const int WINDOW = 32768, HASH_SIZE = 1 << 15, MAX_CHAIN = 32, MAX_MATCH = 258;
+    std::vector<int32_t> head(HASH_SIZE, -1), prev(WINDOW, -1);
+    BitWriter w(out);
+    w.put(1, 1);   // last block
+    w.put(1, 2);   // fixed codes
+    size_t n = in.size(), i = 0;
+    auto hashAt = [&](size_t p) { return ((in[p] << 10) ^ (in[p + 1] << 5) ^ in[p + 2]) & (HASH_SIZE - 1); };
+    auto insert = [&](size_t p) {
+        if (p + 2 >= n) return;
+        int h = hashAt(p);
+        prev[p & (WINDOW - 1)] = head[h];
+        head[h] = (int32_t)p;
+    };
+    while (i < n) {
+        int bestLen = 0, bestDist = 0;
+        if (i + 2 < n) {
+            int limit = (int)std::min<size_t>(MAX_MATCH, n - i);
+            int32_t cand = head[hashAt(i)];
+            for (int chain = 0; cand >= 0 && chain < MAX_CHAIN && i - cand <= (size_t)WINDOW; ++chain) {
+                int len = 0;
+                while (len < limit && in[cand + len] == in[i + len]) ++len;
+                if (len > bestLen) {
+                    bestLen = len;
+                    bestDist = (int)(i - cand);
+                    if (len == limit) break;
+                }
+                int32_t next = prev[cand & (WINDOW - 1)];
+                if (next >= cand) break;
+                cand = next;
+            }
+        }
+        if (bestLen >= 3) {
+            putMatch(w, bestLen, bestDist);
+            for (int k = 0; k < bestLen; ++k) insert(i + k);
+            i += bestLen;
+        }
+        else {
+            putFixedSymbol(w, in[i]);
+            insert(i);
+            ++i;
+        }
+    }
+    putFixedSymbol(w, 256);
+    w.flush();
+}
+
+struct CrcTable {
+    uint32_t v[256];
+    CrcTable() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            v[i] = c;
+        }
+    }
+};
+
+uint32_t crc32(const uint8_t* p, size_t n) {
+    static const CrcTable table;
+    uint32_t crc = ~0u;
+    for (size_t i = 0; i < n; ++i) crc = table.v[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+void putBE32(std::vector<uint8_t>& out, uint32_t v) {
+    uint8_t b[4] = { (uint8_t)(v >> 24), (uint8_t)(v >> 16), (uint8_t)(v >> 8), (uint8_t)v };
+    out.insert(out.end(), b, b + 4);
+}
+
+void putChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& body) {
+    putBE32(out, (uint32_t)body.size());
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), body.begin(), body.end());
+    putBE32(out, crc32(&out[start], out.size() - start));
+}
+
+}
+
+void encodePng(const Image& image, std::vector<uint8_t>& out) {
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    out.assign(signature, signature + 8);
+
+    std::vector<uint8_t> header;
+    putBE32(header, (uint32_t)image.width);
+    putBE32(header, (uint32_t)image.height);
+    uint8_t rest[5] = { 8, 6, 0, 0, 0 };   // 8-bit RGBA, no interlace
+    header.insert(header.end(), rest, rest + 5);
+    putChunk(out, "IHDR", header);
+
+    // Each row takes the Sub or Up filter, whichever leaves the smaller
+    // absolute sum, as libpng's heuristic does.
+    size_t stride = (size_t)image.width * 4;
+    std::vector<uint8_t> raw;
+    raw.reserve((stride + 1) * image.height);
+    std::vector<uint8_t> sub(stride), up(stride);
+    for (int y = 0; y < image.height; ++y) {
+        const uint8_t* row = &image.rgba[y * stride];
+        const uint8_t* above = y > 0 ? row - stride : nullptr;
+        uint32_t subSum = 0, upSum = 0;
+        for (size_t x = 0; x < stride; ++x) {
+            sub[x] = (uint8_t)(row[x] - (x >= 4 ? row[x - 4] : 0));
+            up[x] = (uint8_t)(row[x] - (above ? above[x] : 0));
+            subSum += sub[x] < 128 ? sub[x] : 256 - sub[x];
+            upSum += up[x] < 128 ? up[x] : 256 - up[x];
+        }
+        bool useUp = upSum < subSum;
+        raw.push_back(useUp ? 2 : 1);
+        raw.insert(raw.end(), useUp ? up.begin() : sub.begin(), useUp ? up.end() : sub.end());
+    }
+    std::vector<uint8_t> z = { 0x78, 0x01 };
+    deflateFixed(raw, z);
+    uint32_t a = 1, b = 0;
+    for (uint8_t v : raw) {
+        a = (a + v) % 65521;
+        b = (b + a) % 65521;
+    }
+    putBE32(z, (b << 16) | a);
+    putChunk(out, "IDAT", z);
+    putChunk(out, "IEND", std::vector<uint8_t>());
+}
+
+bool loadPng(const std::string& path, Image& out) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    std::vector<uint8_t> bytes;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) bytes.insert(bytes.end(), chunk, chunk + n);
+    fclose(f);
+    return decodePng(bytes.data(), bytes.size(), out);
+}
+
+bool readPngSize(const std::string& path, int& width, int& height) {
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    uint8_t head[24];
+    bool ok = fread(head, 1, sizeof(head), f) == sizeof(head);
+    fclose(f);
+    if (!ok || memcmp(head, signature, 8) != 0 || memcmp(head + 12, "IHDR", 4) != 0) return false;
+    width = (int)readBE32(head + 16);
+    height = (int)readBE32(head + 20);
+    return width > 0 && height > 0;
+}
+
+bool savePng(const std::string& path, const Image& image) {
+    std::vector<uint8_t> png;
+    encodePng(image, png);
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(png.data(), 1, png.size(), f) == png.size();
+    return fclose(f) == 0 && ok;
+}
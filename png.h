@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Small PNG decoder for the assets we ship: 8-bit greyscale, RGB, palette,
+// grey+alpha and RGBA, non-interlaced. Output is always tightly packed RGBA8.
+// The encoder writes RGBA8 with fixed-Huffman deflate, for images the game
+// generates itself.
+
+struct Image {
+    int width = 0, height = 0;
+    std::vector<uint8_t> rgba;
+};
+
+// zlib stream (RFC 1950/1951) into out; false on corrupt data.
+bool inflateZlib(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+bool decodePng(const uint8_t* data, size_t size, Image& out);
+void encodePng(const Image& image, std::vector<uint8_t>& out);
+// Whole-file helpers; paths are passed to fopen as they are.
+bool loadPng(const std::string& path, Image& out);
+// Size from the IHDR chunk alone, without reading the rest of the file.
+bool readPngSize(const std::string& path, int& width, int& height);
+bool savePng(const std::string& path, const Image& image);
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Fixed-capacity storage for objects of one type. The slots are allocated
+// once up front; spawn() constructs into a free slot and despawn() destroys
+// it and puts the slot back on the free list, both O(1), so objects that come
+// and go every frame never touch the heap. Live objects are also kept in a
+// dense array for iteration, in no particular order.
+template <typename T>
+class ObjectPool {
+private:
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+    Slot* slots;
+    Slot* freeList;
+    size_t cap;
+    std::vector<T*> live;
+    std::vector<uint32_t> liveIndex;  // per slot, its position in live
+
+    size_t slotOf(const T* obj) const { return (size_t)(reinterpret_cast<const Slot*>(obj) - slots); }
+public:
+    explicit ObjectPool(size_t capacity)
+        : slots(new Slot[capacity]), freeList(nullptr), cap(capacity), liveIndex(capacity, 0) {
+        live.reserve(capacity);
+        for (size_t i = capacity; i-- > 0;) {
+            slots[i].next = freeList;
+            freeList = &slots[i];
+        }
+    }
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+    ~ObjectPool() {
+        clear();
+        delete[] slots;
+    }
+
+    // nullptr when the pool is full.
+    template <typename... Args>
+    T* spawn(Args&&... args) {
+        if (!freeList) return nullptr;
+        Slot* s = freeList;
+        freeList = s->next;
+        T* obj = new (s->storage) T(std::forward<Args>(args)...);
+        liveIndex[slotOf(obj)] = (uint32_t)live.size();
+        live.push_back(obj);
+        return obj;
+    }
+
+    // obj must have come from this pool's spawn().
+    void despawn(T* obj) {
+        uint32_t i = liveIndex[slotOf(obj)];
+        T* last = live.back();
+        live[i] = last;
+        liveIndex[slotOf(last)] = i;
+        live.pop_back();
+        obj->~T();
+        Slot* s = reinterpret_cast<Slot*>(obj);
+        s->next = freeList;
+        freeList = s;
+    }
+
+    void clear() {
+        while (!live.empty()) despawn(live.back());
+    }
+
+    size_t size() const { return live.size(); }
+    size_t capacity() const { return cap; }
+    bool isFull() const { return freeList == nullptr; }
+    T* const* begin() const { return live.data(); }
+    T* const* end() const { return live.data() + live.size(); }
+};
@@ -0,0 +1,107 @@
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Each slot carries a sequence number: odd while a writer is filling it,
+// 2 * (ticket + 1) once complete. Readers skip slots that are mid-write or
+// were overwritten while being copied.
+struct Slot {
+    std::atomic<uint64_t> seq{ 0 };
+    const char* name = nullptr;
+    uint64_t startNs = 0, durationNs = 0;
+    uint32_t thread = 0;
+};
+
+Slot ring[PROFILE_CAPACITY];
+std::atomic<uint64_t> nextTicket{ 0 };
+const auto epoch = std::chrono::steady_clock::now();
+
+uint32_t threadTag() {
+    static thread_local uint32_t tag = (uint32_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+    return tag;
+}
+
+struct Event {
+    const char* name;
+    uint64_t startNs, durationNs;
+    uint32_t thread;
+};
+
+void collect(std::vector<Event>& out) {
+    uint64_t end = nextTicket.load(std::memory_order_acquire);
+    uint64_t begin = end > PROFILE_CAPACITY ? end - PROFILE_CAPACITY : 0;
+    out.reserve((size_t)(end - begin));
+    for (uint64_t t = begin; t < end; ++t) {
+        Slot& s = ring[t & (PROFILE_CAPACITY - 1)];
+        uint64_t expected = 2 * (t + 1);
+        if (s.seq.load(std::memory_order_acquire) != expected) continue;
+        Event e = { s.name, s.startNs, s.durationNs, s.thread };
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.seq.load(std::memory_order_relaxed) != expected) continue;
+        out.push_back(e);
+    }
+}
+
+}
+
+uint64_t profileNowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count();
+}
+
+void profileRecord(const char* name, uint64_t startNs, uint64_t durationNs) {
+    uint64_t ticket = nextTicket.fetch_add(1, std::memory_order_relaxed);
+    Slot& s = ring[ticket & (PROFILE_CAPACITY - 1)];
+    s.seq.store(2 * ticket + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.name = name;
+    s.startNs = startNs;
+    s.durationNs = durationNs;
+    s.thread = threadTag();
+    s.seq.store(2 * (ticket + 1), std::memory_order_release);
+}
+
+ProfileStats profileStats(const char* name) {
+    // Kept between calls so the in-game overlay does not allocate.
+    static thread_local std::vector<Event> events;
+    static thread_local std::vector<uint64_t> durations;
+    events.clear();
+    collect(events);
+    durations.clear();
+    for (const Event& e : events)
+        if (e.name == name || strcmp(e.name, name) == 0) durations.push_back(e.durationNs);
+
+    ProfileStats stats;
+    if (durations.empty()) return stats;
+    std::sort(durations.begin(), durations.end());
+    size_t n = durations.size();
+    stats.count = (int)n;
+    stats.p50Ms = durations[n / 2] * 1e-6;
+    stats.p99Ms = durations[std::min(n - 1, n * 99 / 100)] * 1e-6;
+    stats.maxMs = durations[n - 1] * 1e-6;
+    return stats;
+}
+
+bool profileExportChromeTrace(const std::string& path) {
+    std::vector<Event> events;
+    collect(events);
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return false;
+    fprintf(f, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < events.size(); ++i) {
+        const Event& e = events[i];
+        fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+            e.name, e.thread, e.startNs * 1e-3, e.durationNs * 1e-3, i + 1 < events.size() ? "," : "");
+    }
+    fprintf(f, "],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(f);
+    return true;
+}
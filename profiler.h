@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Hot-path timing. PROFILE_SCOPE records how long the enclosing scope took
+// into a fixed-size lock-free ring of recent events. Build with
+// KOMBAT_PROFILE defined to enable it; otherwise the macros expand to nothing.
+// Event names must be string literals (only the pointer is stored).
+
+const size_t PROFILE_CAPACITY = 1 << 14;
+
+struct ProfileStats {
+    int count = 0;
+    double p50Ms = 0.0, p99Ms = 0.0, maxMs = 0.0;
+};
+
+uint64_t profileNowNs();
+void profileRecord(const char* name, uint64_t startNs, uint64_t durationNs);
+// Percentiles over the events of this name still in the ring.
+ProfileStats profileStats(const char* name);
+bool profileExportChromeTrace(const std::string& path);
+
+class ProfileScope {
+private:
+    const char* name;
+    uint64_t start;
+public:
+    explicit ProfileScope(const char* n) : name(n), start(profileNowNs()) {}
+    ~ProfileScope() { profileRecord(name, start, profileNowNs() - start); }
+};
+
+#ifdef KOMBAT_PROFILE
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_RECORD(name, startNs, durationNs) profileRecord(name, startNs, durationNs)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_RECORD(name, startNs, durationNs) ((void)0)
+#endif
@@ -0,0 +1,429 @@
+#include "raster.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Printable ASCII, 8x16 one bit per pixel, rows top down and the leftmost
+// pixel in the top bit. Row 12 sits on the baseline. Rasterized from DejaVu
+// Sans Mono Bold.
+static const uint8_t FONT_GLYPHS[95][16] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // ' '
+    { 0x00, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00 },   // '!'
+    { 0x24, 0x66, 0x66, 0x66, 0x24, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '"'
+    { 0x00, 0x12, 0x16, 0x7f, 0x7f, 0x34, 0x24, 0xfe, 0xfe, 0x6c, 0x68, 0x48, 0x00, 0x00, 0x00, 0x00 },   // '#'
+    { 0x18, 0x18, 0x3c, 0x7e, 0x78, 0x78, 0x7c, 0x1e, 0x1e, 0x1e, 0x7e, 0x7c, 0x18, 0x18, 0x00, 0x00 },   // '$'
+    { 0x00, 0x70, 0xf0, 0xd0, 0xf0, 0x66, 0x18, 0x66, 0x0f, 0x09, 0x0b, 0x0e, 0x00, 0x00, 0x00, 0x00 },   // '%'
+    { 0x1c, 0x3c, 0x60, 0x60, 0x30, 0x30, 0x79, 0xdf, 0xcf, 0xce, 0x7e, 0x7f, 0x00, 0x00, 0x00, 0x00 },   // '&'
+    { 0x00, 0x18, 0x18, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // "'"
+    { 0x0c, 0x08, 0x18, 0x18, 0x18, 0x10, 0x30, 0x30, 0x30, 0x18, 0x18, 0x18, 0x08, 0x0c, 0x00, 0x00 },   // '('
+    { 0x30, 0x10, 0x18, 0x18, 0x18, 0x08, 0x0c, 0x0c, 0x0c, 0x18, 0x18, 0x18, 0x10, 0x30, 0x00, 0x00 },   // ')'
+    { 0x00, 0x18, 0x7e, 0x3c, 0x3c, 0x7e, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '*'
+    { 0x00, 0x00, 0x00, 0x18, 0x18, 0x18, 0x7e, 0xff, 0x18, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '+'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x18, 0x18, 0x30, 0x00, 0x00 },   // ','
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3c, 0x3c, 0x3c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '-'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00 },   // '.'
+    { 0x02, 0x06, 0x06, 0x04, 0x0c, 0x08, 0x18, 0x18, 0x10, 0x30, 0x20, 0x20, 0x60, 0x40, 0x00, 0x00 },   // '/'
+    { 0x18, 0x3c, 0x7e, 0x66, 0x66, 0x66, 0x7e, 0x66, 0x66, 0x66, 0x7e, 0x3c, 0x00, 0x00, 0x00, 0x00 },   // '0'
+    { 0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x7e, 0x7e, 0x00, 0x00, 0x00, 0x00 },   // '1'
+    { 0x38, 0x7c, 0x4e, 0x06, 0x06, 0x0c, 0x0c, 0x18, 0x30, 0x60, 0x7e, 0x7e, 0x00, 0x00, 0x00, 0x00 },   // '2'
+    { 0x38, 0x7c, 0x4e, 0x06, 0x06, 0x3c, 0x3c, 0x06, 0x06, 0x06, 0x7e, 0x7c, 0x00, 0x00, 0x00, 0x00 },   // '3'
+    { 0x04, 0x0c, 0x1c, 0x1c, 0x3c, 0x2c, 0x6c, 0x4c, 0x7f, 0x7e, 0x0c, 0x0c, 0x00, 0x00, 0x00, 0x00 },   // '4'
+    { 0x3c, 0x7e, 0x7c, 0x60, 0x70, 0x7c, 0x7e, 0x06, 0x06, 0x06, 0x7e, 0x7c, 0x00, 0x00, 0x00, 0x00 },   // '5'
+    { 0x0c, 0x3e, 0x72, 0x60, 0x68, 0x7e, 0x76, 0x66, 0x66, 0x66, 0x7e, 0x3c, 0x00, 0x00, 0x00, 0x00 },   // '6'
+    { 0x7e, 0x7e, 0x7e, 0x06, 0x0c, 0x0c, 0x0c, 0x18, 0x18, 0x18, 0x30, 0x30, 0x00, 0x00, 0x00, 0x00 },   // '7'
+    { 0x18, 0x3c, 0x66, 0x66, 0x66, 0x3c, 0x3c, 0x66, 0x66, 0x66, 0x7e, 0x3c, 0x00, 0x00, 0x00, 0x00 },   // '8'
+    { 0x18, 0x7c, 0x6e, 0x66, 0x66, 0x66, 0x7e, 0x3e, 0x06, 0x06, 0x7c, 0x7c, 0x10, 0x00, 0x00, 0x00 },   // '9'
+    { 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x18, 0x00, 0x00, 0x18, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00 },   // ':'
+    { 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x18, 0x00, 0x00, 0x18, 0x18, 0x18, 0x18, 0x30, 0x00, 0x00 },   // ';'
+    { 0x00, 0x00, 0x00, 0x03, 0x0f, 0x3c, 0x70, 0xe0, 0x7c, 0x0e, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '<'
+    { 0x00, 0x00, 0x00, 0x00, 0x7e, 0xff, 0x00, 0x00, 0xff, 0x7e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '='
+    { 0x00, 0x00, 0x00, 0xc0, 0xf0, 0x3c, 0x0e, 0x07, 0x3e, 0x70, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '>'
+    { 0x18, 0x7e, 0x66, 0x06, 0x0e, 0x0c, 0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00 },   // '?'
+    { 0x00, 0x1c, 0x3e, 0x62, 0x43, 0xdf, 0xd3, 0xb3, 0xb3, 0xd3, 0xdf, 0x40, 0x60, 0x3e, 0x0c, 0x00 },   // '@'
+    { 0x18, 0x18, 0x3c, 0x3c, 0x3c, 0x3c, 0x66, 0x7e, 0x7e, 0x66, 0x66, 0xc3, 0x00, 0x00, 0x00, 0x00 },   // 'A'
+    { 0x78, 0x7e, 0x66, 0x66, 0x66, 0x7c, 0x7e, 0x66, 0x67, 0x67, 0x7e, 0x7e, 0x00, 0x00, 0x00, 0x00 },   // 'B'
+    { 0x0c, 0x3e, 0x3a, 0x70, 0x60, 0x60, 0x60, 0x60, 0x60, 0x70, 0x3e, 0x1e, 0x00, 0x00, 0x00, 0x00 },   // 'C'
+    { 0x70, 0x7c, 0x7e, 0x66, 0x66, 0x66, 0x67, 0x66, 0x66, 0x66, 0x7e, 0x7c, 0x00, 0x00, 0x00, 0x00 },   // 'D'
+    { 0x7e, 0x7e, 0x7e, 0x60, 0x60, 0x7e, 0x7e, 0x60, 0x60, 0x60, 0x7e, 0x7e, 0x00, 0x00, 0x00, 0x00 },   // 'E'
+    { 0x3e, 0x7e, 0x7e, 0x60, 0x60, 0x7e, 0x7e, 0x60, 0x60, 0x60, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00 },   // 'F'
+    { 0x0c, 0x3e, 0x72, 0x60, 0x60, 0x60, 0x6e, 0x6e, 0x62, 0x62, 0x3e, 0x3e, 0x00, 0x00, 0x00, 0x00 },   // 'G'
+    { 0x42, 0x66, 0x66, 0x66, 0x66, 0x7e, 0x7e, 0x66, 0x66, 0x66, 0x66, 0x66, 0x00, 0x00, 0x00, 0x00 },   // 'H'
+    { 0x7e, 0x7e, 0x7e, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x7e, 0x7e, 0x00, 0x00, 0x00, 0x00 },   // 'I'
+    { 0x1c, 0x3e, 0x1e, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x0e, 0x7c, 0x7c, 0x00, 0x00, 0x00, 0x00 },   // 'J'
+    { 0x42, 0x66, 0x6e, 0x6c, 0x78, 0x78, 0x78, 0x6c, 0x6c, 0x66, 0x66, 0x67, 0x00, 0x00, 0x00, 0x00 },   // 'K'
+    { 0x20, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x7e, 0x7f, 0x00, 0x00, 0x00, 0x00 },   // 'L'
+    { 0x46, 0xe7, 0xe7, 0xff, 0xff, 0xff, 0xdb, 0xdb, 0xc3, 0xc3, 0xc3, 0xc3, 0x00, 0x00, 0x00, 0x00 },   // 'M'
+    { 0x42, 0x66, 0x66, 0x76, 0x76, 0x76, 0x7e, 0x6e, 0x6e, 0x6e, 0x66, 0x66, 0x00, 0x00, 0x00, 0x00 },   // 'N'
+    { 0x18, 0x3c, 0x7e, 0x66, 0x66, 0x66, 0xe7, 0x66, 0x66, 0x66, 0x7e, 0x3c, 0x00, 0x00, 0x00, 0x00 },   // 'O'
+    { 0x78, 0x7e, 0x7e, 0x66, 0x67, 0x66, 0x7e, 0x7c, 0x60, 0x60, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00 },   // 'P'
+    { 0x18, 0x3c, 0x7e, 0x66, 0x66, 0x66, 0xe7, 0x66, 0x66, 0x66, 0x7e, 0x3c, 0x0c, 0x06, 0x00, 0x00 },   // 'Q'
+    { 0x78, 0x7c, 0x7e, 0x66, 0x66, 0x7e, 0x7c, 0x7c, 0x6e, 0x66, 0x66, 0x63, 0x00, 0x00, 0x00, 0x00 },   // 'R'
+    { 0x18, 0x7e, 0x66, 0x60, 0x60, 0x78, 0x3e, 0x0e, 0x06, 0x06, 0x7e, 0x7c, 0x00, 0x00, 0x00, 0x00 },   // 'S'
+    { 0x7e, 0xff, 0x7e, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00 },   // 'T'
+    { 0x42, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x7e, 0x3c, 0x00, 0x00, 0x00, 0x00 },   // 'U'
+    { 0x42, 0x66, 0x66, 0x66, 0x66, 0x66, 0x24, 0x3c, 0x3c, 0x3c, 0x3c, 0x3c, 0x00, 0x00, 0x00, 0x00 },   // 'V'
+    { 0x81, 0xc3, 0xc3, 0xc3, 0xdb, 0xdb, 0x7b, 0x7e, 0x7e, 0x66, 0x66, 0x66, 0x00, 0x00, 0x00, 0x00 },   // 'W'
+    { 0x42, 0x66, 0x66, 0x3c, 0x3c, 0x18, 0x18, 0x3c, 0x3c, 0x66, 0x66, 0xe7, 0x00, 0x00, 0x00, 0x00 },   // 'X'
+    { 0x42, 0xe7, 0x66, 0x66, 0x3c, 0x3c, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00 },   // 'Y'
+    { 0x7e, 0x7f, 0x7e, 0x0e, 0x0c, 0x1c, 0x18, 0x38, 0x30, 0x60, 0x7e, 0x7f, 0x00, 0x00, 0x00, 0x00 },   // 'Z'
+    { 0x1c, 0x1c, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1c, 0x00, 0x00 },   // '['
+    { 0x40, 0x60, 0x60, 0x20, 0x30, 0x10, 0x18, 0x18, 0x08, 0x0c, 0x04, 0x04, 0x06, 0x02, 0x00, 0x00 },   // '\\'
+    { 0x38, 0x38, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x38, 0x00, 0x00 },   // ']'
+    { 0x18, 0x18, 0x3c, 0x66, 0x42, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '^'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff },   // '_'
+    { 0x30, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '`'
+    { 0x00, 0x00, 0x00, 0x3c, 0x7e, 0x06, 0x1e, 0x7e, 0x66, 0x66, 0x66, 0x7e, 0x00, 0x00, 0x00, 0x00 },   // 'a'
+    { 0x60, 0x60, 0x60, 0x6c, 0x7e, 0x76, 0x66, 0x67, 0x66, 0x66, 0x7e, 0x7e, 0x00, 0x00, 0x00, 0x00 },   // 'b'
+    { 0x00, 0x00, 0x00, 0x1c, 0x3e, 0x72, 0x60, 0x60, 0x60, 0x60, 0x3e, 0x3e, 0x00, 0x00, 0x00, 0x00 },   // 'c'
+    { 0x06, 0x06, 0x06, 0x36, 0x7e, 0x6e, 0x66, 0xe6, 0x66, 0x66, 0x7e, 0x7e, 0x00, 0x00, 0x00, 0x00 },   // 'd'
+    { 0x00, 0x00, 0x00, 0x1c, 0x7e, 0x66, 0x66, 0x7f, 0x7e, 0x60, 0x7e, 0x3e, 0x00, 0x00, 0x00, 0x00 },   // 'e'
+    { 0x0e, 0x1e, 0x18, 0x3e, 0x7e, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00 },   // 'f'
+    { 0x00, 0x00, 0x00, 0x32, 0x7e, 0x66, 0x66, 0x66, 0x66, 0x66, 0x7e, 0x3e, 0x06, 0x2e, 0x7c, 0x10 },   // 'g'
+    { 0x60, 0x60, 0x60, 0x6c, 0x7e, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x00, 0x00, 0x00, 0x00 },   // 'h'
+    { 0x18, 0x18, 0x00, 0x38, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0x7e, 0x7f, 0x00, 0x00, 0x00, 0x00 },   // 'i'
+    { 0x1c, 0x08, 0x00, 0x38, 0x3c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x18, 0x78, 0x60 },   // 'j'
+    { 0x60, 0x60, 0x60, 0x62, 0x6e, 0x6c, 0x78, 0x78, 0x6c, 0x6c, 0x66, 0x66, 0x00, 0x00, 0x00, 0x00 },   // 'k'
+    { 0xf8, 0x78, 0x38, 0x38, 0x38, 0x38, 0x38, 0x38, 0x38, 0x38, 0x1e, 0x1e, 0x00, 0x00, 0x00, 0x00 },   // 'l'
+    { 0x00, 0x00, 0x00, 0x76, 0xfe, 0xdb, 0xdb, 0xdb, 0xdb, 0xdb, 0xdb, 0xdb, 0x00, 0x00, 0x00, 0x00 },   // 'm'
+    { 0x00, 0x00, 0x00, 0x6c, 0x7e, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x00, 0x00, 0x00, 0x00 },   // 'n'
+    { 0x00, 0x00, 0x00, 0x18, 0x7e, 0x66, 0x66, 0x66, 0x66, 0x66, 0x7e, 0x3c, 0x00, 0x00, 0x00, 0x00 },   // 'o'
+    { 0x00, 0x00, 0x00, 0x4c, 0x7e, 0x76, 0x66, 0x67, 0x66, 0x66, 0x7e, 0x7e, 0x60, 0x60, 0x60, 0x40 },   // 'p'
+    { 0x00, 0x00, 0x00, 0x32, 0x7e, 0x6e, 0x66, 0xe6, 0x66, 0x66, 0x7e, 0x7e, 0x06, 0x06, 0x06, 0x02 },   // 'q'
+    { 0x00, 0x00, 0x00, 0x26, 0x3f, 0x38, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x00, 0x00, 0x00, 0x00 },   // 'r'
+    { 0x00, 0x00, 0x00, 0x3c, 0x7e, 0x60, 0x70, 0x3c, 0x1e, 0x06, 0x66, 0x7c, 0x00, 0x00, 0x00, 0x00 },   // 's'
+    { 0x00, 0x38, 0x38, 0x7e, 0x7e, 0x38, 0x38, 0x38, 0x38, 0x38, 0x1e, 0x1e, 0x00, 0x00, 0x00, 0x00 },   // 't'
+    { 0x00, 0x00, 0x00, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x7e, 0x7e, 0x00, 0x00, 0x00, 0x00 },   // 'u'
+    { 0x00, 0x00, 0x00, 0x42, 0x66, 0x66, 0x66, 0x24, 0x3c, 0x3c, 0x3c, 0x18, 0x00, 0x00, 0x00, 0x00 },   // 'v'
+    { 0x00, 0x00, 0x00, 0x81, 0xc3, 0xc3, 0xdb, 0x5a, 0x7e, 0x7e, 0x66, 0x66, 0x00, 0x00, 0x00, 0x00 },   // 'w'
+    { 0x00, 0x00, 0x00, 0x66, 0x66, 0x3c, 0x3c, 0x18, 0x3c, 0x3c, 0x66, 0x66, 0x00, 0x00, 0x00, 0x00 },   // 'x'
+    { 0x00, 0x00, 0x00, 0x42, 0x66, 0x66, 0x66, 0x3c, 0x3c, 0x3c, 0x18, 0x18, 0x18, 0x30, 0x70, 0x60 },   // 'y'
+    { 0x00, 0x00, 0x00, 0x3e, 0x7e, 0x06, 0x0c, 0x18, 0x38, 0x30, 0x7e, 0x7e, 0x00, 0x00, 0x00, 0x00 },   // 'z'
+    { 0x0e, 0x1c, 0x18, 0x18, 0x18, 0x18, 0x38, 0x70, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1e, 0x0e, 0x00 },   // '{'
+    { 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18 },   // '|'
+    { 0x70, 0x38, 0x18, 0x18, 0x18, 0x18, 0x1c, 0x0e, 0x18, 0x18, 0x18, 0x18, 0x18, 0x78, 0x70, 0x00 },   // '}'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7b, 0xfe, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '~'
+};
+
+static const int GLYPH_ROWS = 16, GLYPH_BASELINE = 12;
+
+static uint32_t packPremultiplied(const RasterColor& c) {
+    float a = std::min(std::max(c.a, 0.f), 1.f);
+    auto channel = [a](float v) { return (uint32_t)(std::min(std::max(v, 0.f), 1.f) * a * 255.f + 0.5f); };
+    return channel(c.r) | (channel(c.g) << 8) | (channel(c.b) << 16) | ((uint32_t)(a * 255.f + 0.5f) << 24);
+}
+
+// x * y / 255, rounded, for bytes.
+static inline uint32_t mul255(uint32_t x, uint32_t y) {
+    uint32_t t = x * y + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+static inline uint32_t tintScalar(uint32_t s, uint32_t tint) {
+    return mul255(s & 0xff, tint & 0xff) | (mul255((s >> 8) & 0xff, (tint >> 8) & 0xff) << 8) |
+        (mul255((s >> 16) & 0xff, (tint >> 16) & 0xff) << 16) | (mul255(s >> 24, tint >> 24) << 24);
+}
+
+// Premultiplied source over destination.
+static inline uint32_t blendScalar(uint32_t d, uint32_t s) {
+    uint32_t inv = 255 - (s >> 24);
+    return s + (mul255(d & 0xff, inv) | (mul255((d >> 8) & 0xff, inv) << 8) |
+        (mul255((d >> 16) & 0xff, inv) << 16) | (mul255(d >> 24, inv) << 24));
+}
+
+#if KOMBAT_SIMD
+// x * y / 255 on eight 16-bit lanes holding bytes.
+static inline __m128i simdMul255(__m128i x, __m128i y) {
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(x, y), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// 255 - alpha of two pixels, spread over all four channels of each.
+static inline __m128i simdInvAlpha(__m128i px16) {
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm_sub_epi16(_mm_set1_epi16(255), a);
+}
+
+// Four premultiplied pixels over four destination pixels.
+static inline __m128i simdBlend(__m128i d, __m128i s) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i slo = _mm_unpacklo_epi8(s, zero), shi = _mm_unpackhi_epi8(s, zero);
+    __m128i lo = _mm_add_epi16(slo, simdMul255(_mm_unpacklo_epi8(d, zero), simdInvAlpha(slo)));
+    __m128i hi = _mm_add_epi16(shi, simdMul255(_mm_unpackhi_epi8(d, zero), simdInvAlpha(shi)));
+    return _mm_packus_epi16(lo, hi);
+}
+#endif
+
+void makeRasterTexture(const uint8_t* rgba, int width, int height, RasterTexture& out) {
+    out.width = width;
+    out.height = height;
+    out.texels.resize((size_t)width * height);
+    out.opaque = true;
+    for (size_t i = 0; i < out.texels.size(); ++i) {
+        const uint8_t* p = rgba + i * 4;
+        uint32_t a = p[3];
+        out.texels[i] = mul255(p[0], a) | (mul255(p[1], a) << 8) | (mul255(p[2], a) << 16) | (a << 24);
+        if (a != 255) out.opaque = false;
+    }
+}
+
+void Rasterizer::resize(int w, int h) {
+    width = w;
+    height = h;
+    pixels.assign((size_t)w * h, 0xff000000u);
+    columns.resize(w);
+    setClip(0, 0, w, h);
+}
+
+void Rasterizer::setClip(int x0, int y0, int x1, int y1) {
+    clipX0 = std::max(x0, 0);
+    clipY0 = std::max(y0, 0);
+    clipX1 = std::min(x1, width);
+    clipY1 = std::min(y1, height);
+}
+
+void Rasterizer::clear(const RasterColor& c) {
+    RasterColor opaque = c;
+    opaque.a = 1.f;
+    std::fill(pixels.begin(), pixels.end(), packPremultiplied(opaque));
+}
+
+void Rasterizer::blendSpan(uint32_t* dst, int count, uint32_t color) {
+    uint32_t a = color >> 24;
+    if (a == 0) return;
+    if (a == 255) {
+        std::fill(dst, dst + count, color);
+        return;
+    }
+    int i = 0;
+#if KOMBAT_SIMD
+    __m128i s = _mm_set1_epi32((int)color);
+    for (; i + 4 <= count; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        _mm_storeu_si128((__m128i*)(dst + i), simdBlend(d, s));
+    }
+#endif
+    for (; i < count; ++i) dst[i] = blendScalar(dst[i], color);
+}
+
+void Rasterizer::textureSpan(uint32_t* dst, int count, const uint32_t* row, const int* cols, uint32_t tint, bool copy) {
+    if (copy) {
+        for (int i = 0; i < count; ++i) dst[i] = row[cols[i]];
+        return;
+    }
+    bool tinted = tint != 0xffffffffu;
+    int i = 0;
+#if KOMBAT_SIMD
+    __m128i zero = _mm_setzero_si128();
+    __m128i tint16 = _mm_unpacklo_epi8(_mm_set1_epi32((int)tint), zero);
+    __m128i alphaMask = _mm_set1_epi32((int)0xff000000u);
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_set_epi32((int)row[cols[i + 3]], (int)row[cols[i + 2]], (int)row[cols[i + 1]], (int)row[cols[i]]);
+        if (tinted) {
+            s = _mm_packus_epi16(simdMul255(_mm_unpacklo_epi8(s, zero), tint16),
+                simdMul255(_mm_unpackhi_epi8(s, zero), tint16));
+        }
+        // Sprites are mostly fully clear or fully solid.
+        int clear = _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alphaMask), zero));
+        if (clear == 0xffff) continue;
+        int solid = _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alphaMask), alphaMask));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        _mm_storeu_si128((__m128i*)(dst + i), solid == 0xffff ? s : simdBlend(d, s));
+    }
+#endif
+    for (; i < count; ++i) {
+        uint32_t s = row[cols[i]];
+        if (tinted) s = tintScalar(s, tint);
+        dst[i] = blendScalar(dst[i], s);
+    }
+}
+
+// Pixels whose centers fall in [lo, hi), clamped to [clipLo, clipHi).
+static inline void coveredRange(float lo, float hi, int clipLo, int clipHi, int& first, int& end) {
+    if (lo > hi) std::swap(lo, hi);
+    first = std::max((int)std::ceil(lo - 0.5f), clipLo);
+    end = std::min((int)std::ceil(hi - 0.5f), clipHi);
+}
+
+void Rasterizer::fillRect(float x0, float y0, float x1, float y1, const RasterColor& c, const RasterTexture* tex,
+    const RasterRegion* region) {
+    int px0, px1, py0, py1;
+    coveredRange(x0, x1, clipX0, clipX1, px0, px1);
+    coveredRange(y0, y1, clipY0, clipY1, py0, py1);
+    if (px0 >= px1 || py0 >= py1) return;
+    ++stats.fills;
+    int count = px1 - px0;
+    stats.pixels += (uint64_t)count * (py1 - py0);
+    uint32_t color = packPremultiplied(c);
+    if (!tex || tex->texels.empty()) {
+        for (int y = py0; y < py1; ++y) blendSpan(&pixels[(size_t)y * width + px0], count, color);
+        return;
+    }
+    if (color >> 24 == 0) return;
+    stats.texels += (uint64_t)count * (py1 - py0);
+
+    RasterRegion whole;
+    if (!region) {
+        whole.width = tex->width;
+        whole.height = tex->height;
+        whole.opaque = tex->opaque;
+        region = &whole;
+    }
+    // Flipped rectangles mirror the image, as SGG does with a negative size.
+    float du = region->width / (x1 - x0), dv = region->height / (y1 - y0);
+    for (int i = 0; i < count; ++i) {
+        int u = (int)((px0 + i + 0.5f - x0) * du);
+        columns[i] = region->x + std::min(std::max(u, 0), region->width - 1);
+    }
+    bool copy = region->opaque && color == 0xffffffffu;
+    for (int y = py0; y < py1; ++y) {
+        int v = region->y + std::min(std::max((int)((y + 0.5f - y0) * dv), 0), region->height - 1);
+        textureSpan(&pixels[(size_t)y * width + px0], count, &tex->texels[(size_t)v * tex->width], columns.data(), color, copy);
+    }
+}
+
+void Rasterizer::fillGradient(float x0, float y0, float x1, float y1, const RasterColor& c0, const RasterColor& c1, float du, float dv) {
+    int px0, px1, py0, py1;
+    coveredRange(x0, x1, clipX0, clipX1, px0, px1);
+    coveredRange(y0, y1, clipY0, clipY1, py0, py1);
+    if (px0 >= px1 || py0 >= py1) return;
+    ++stats.fills;
+    stats.pixels += (uint64_t)(px1 - px0) * (py1 - py0);
+    for (int y = py0; y < py1; ++y) {
+        float v = (y + 0.5f - y0) / (y1 - y0);
+        uint32_t* row = &pixels[(size_t)y * width];
+        for (int x = px0; x < px1; ++x) {
+            float u = (x + 0.5f - x0) / (x1 - x0);
+            float s = std::min(std::max(u * du + v * dv, 0.f), 1.f);
+            RasterColor c;
+            c.r = c0.r + (c1.r - c0.r) * s;
+            c.g = c0.g + (c1.g - c0.g) * s;
+            c.b = c0.b + (c1.b - c0.b) * s;
+            c.a = c0.a + (c1.a - c0.a) * s;
+            row[x] = blendScalar(row[x], packPremultiplied(c));
+        }
+    }
+}
+
+void Rasterizer::fillQuad(const float* xs, const float* ys, const RasterColor& c, const RasterTexture* tex,
+    const RasterRegion* region) {
+    float ex = xs[1] - xs[0], ey = ys[1] - ys[0];   // u axis
+    float fx = xs[3] - xs[0], fy = ys[3] - ys[0];   // v axis
+    float det = ex * fy - ey * fx;
+    if (det == 0.f) return;
+    float lo[2] = { xs[0], ys[0] }, hi[2] = { xs[0], ys[0] };
+    for (int k = 1; k < 4; ++k) {
+        lo[0] = std::min(lo[0], xs[k]);
+        hi[0] = std::max(hi[0], xs[k]);
+        lo[1] = std::min(lo[1], ys[k]);
+        hi[1] = std::max(hi[1], ys[k]);
+    }
+    int px0, px1, py0, py1;
+    coveredRange(lo[0], hi[0], clipX0, clipX1, px0, px1);
+    coveredRange(lo[1], hi[1], clipY0, clipY1, py0, py1);
+    if (px0 >= px1 || py0 >= py1) return;
+    ++stats.fills;
+    uint32_t color = packPremultiplied(c);
+    bool textured = tex && !tex->texels.empty();
+    int rx = 0, ry = 0, rw = textured ? tex->width : 0, rh = textured ? tex->height : 0;
+    if (textured && region) {
+        rx = region->x;
+        ry = region->y;
+        rw = region->width;
+        rh = region->height;
+    }
+    // u and v step by these per pixel to the right.
+    float uStep = fy / det, vStep = -ey / det;
+    for (int y = py0; y < py1; ++y) {
+        float dx = px0 + 0.5f - xs[0], dy = y + 0.5f - ys[0];
+        float u = (dx * fy - dy * fx) / det, v = (ex * dy - ey * dx) / det;
+        uint32_t* row = &pixels[(size_t)y * width];
+        for (int x = px0; x < px1; ++x, u += uStep, v += vStep) {
+            if (u < 0.f || u >= 1.f || v < 0.f || v >= 1.f) continue;
+            uint32_t s = color;
+            if (textured) {
+                int tx = rx + std::min((int)(u * rw), rw - 1);
+                int ty = ry + std::min((int)(v * rh), rh - 1);
+                s = tintScalar(tex->texels[(size_t)ty * tex->width + tx], color);
+                ++stats.texels;
+            }
+            row[x] = blendScalar(row[x], s);
+            ++stats.pixels;
+        }
+    }
+}
+
+void Rasterizer::fillSector(float cx, float cy, float r0, float r1, float a0, float a1, const RasterColor& c) {
+    const float TWO_PI = 6.28318531f;
+    bool fullTurn = a1 - a0 >= TWO_PI || a0 - a1 >= TWO_PI;
+    if (a1 < a0) std::swap(a0, a1);
+    int py0, py1;
+    coveredRange(cy - r1, cy + r1, clipY0, clipY1, py0, py1);
+    if (py0 >= py1 || r1 <= 0.f) return;
+    ++stats.fills;
+    uint32_t color = packPremultiplied(c);
+    float inner2 = r0 * r0, outer2 = r1 * r1;
+    for (int y = py0; y < py1; ++y) {
+        float dy = y + 0.5f - cy;
+        float half = std::sqrt(std::max(outer2 - dy * dy, 0.f));
+        int px0, px1;
+        coveredRange(cx - half, cx + half, clipX0, clipX1, px0, px1);
+        uint32_t* row = &pixels[(size_t)y * width];
+        if (fullTurn && inner2 <= 0.f) {
+            if (px0 < px1) {
+                blendSpan(row + px0, px1 - px0, color);
+                stats.pixels += px1 - px0;
+            }
+            continue;
+        }
+        for (int x = px0; x < px1; ++x) {
+            float dx = x + 0.5f - cx;
+            float d2 = dx * dx + dy * dy;
+            if (d2 < inner2 || d2 >= outer2) continue;
+            if (!fullTurn) {
+                // Screen y points down, so counter-clockwise is toward -y.
+                float a = std::atan2(-dy, dx);
+                while (a < a0) a += TWO_PI;
+                if (a > a1) continue;
+            }
+            row[x] = blendScalar(row[x], color);
+            ++stats.pixels;
+        }
+    }
+}
+
+float Rasterizer::drawText(float x, float y, float size, const std::string& text, const RasterColor& c) {
+    // Glyphs are narrowed to about the average advance of a proportional font.
+    float scale = size / GLYPH_BASELINE;
+    float advance = size * 0.55f, scaleX = advance / 8.f;
+    float top = y - GLYPH_BASELINE * scale;
+    uint32_t color = packPremultiplied(c);
+    int py0, py1;
+    coveredRange(top, top + GLYPH_ROWS * scale, clipY0, clipY1, py0, py1);
+    float penX = x;
+    for (char ch : text) {
+        int g = (unsigned char)ch - 32;
+        float left = penX;
+        penX += advance;
+        if (g <= 0 || g >= 95) continue;
+        int px0, px1;
+        coveredRange(left, left + advance, clipX0, clipX1, px0, px1);
+        if (px0 >= px1 || py0 >= py1) continue;
+        ++stats.fills;
+        const uint8_t* glyph = FONT_GLYPHS[g];
+        for (int py = py0; py < py1; ++py) {
+            int r = std::min((int)((py + 0.5f - top) / scale), GLYPH_ROWS - 1);
+            uint8_t bits = glyph[r];
+            if (!bits) continue;
+            uint32_t* row = &pixels[(size_t)py * width];
+            for (int px = px0; px < px1; ++px) {
+                int col = std::min((int)((px + 0.5f - left) / scaleX), 7);
+                if (bits & (0x80 >> col)) {
+                    row[px] = blendScalar(row[px], color);
+                    ++stats.pixels;
+                }
+            }
+        }
+    }
+    return penX - x;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Software rasterizer behind the Linux build of the SGG API (sgg_soft.cpp):
+// fills axis-aligned and rotated quads, disks and text into an RGBA8
+// framebuffer held in memory. Coordinates are framebuffer pixels; a pixel is
+// covered when its center is inside the shape. Textures are sampled nearest
+// and blended premultiplied, four pixels at a time with SSE2.
+//
+// Pixels are packed R, G, B, A from the lowest byte up, the same layout as
+// Image::rgba, so a framebuffer can be handed to encodePng() as it is.
+
+struct RasterColor {
+    float r = 1.f, g = 1.f, b = 1.f, a = 1.f;   // straight alpha
+};
+
+struct RasterTexture {
+    int width = 0, height = 0;
+    std::vector<uint32_t> texels;   // premultiplied
+    bool opaque = false;            // every texel has alpha 255
+};
+
+// Part of a texture, in texels, for drawing one image out of an atlas.
+struct RasterRegion {
+    int x = 0, y = 0, width = 0, height = 0;
+    bool opaque = false;   // every texel in it has alpha 255
+};
+
+// Converts decoded RGBA8 into a texture.
+void makeRasterTexture(const uint8_t* rgba, int width, int height, RasterTexture& out);
+
+struct RasterStats {
+    uint32_t fills = 0;      // shapes drawn, text glyphs included
+    uint64_t pixels = 0;     // framebuffer pixels written
+    uint64_t texels = 0;     // texture samples taken
+};
+
+class Rasterizer {
+private:
+    int width = 0, height = 0;
+    std::vector<uint32_t> pixels;
+    int clipX0 = 0, clipY0 = 0, clipX1 = 0, clipY1 = 0;
+    std::vector<int> columns;   // texture column for each pixel of the current span
+    RasterStats stats;
+
+    void blendSpan(uint32_t* dst, int count, uint32_t color);
+    void textureSpan(uint32_t* dst, int count, const uint32_t* row, const int* cols, uint32_t tint, bool copy);
+public:
+    void resize(int w, int h);
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    const uint32_t* getPixels() const { return pixels.data(); }
+    uint32_t getPixel(int x, int y) const { return pixels[(size_t)y * width + x]; }
+
+    // Drawing stays inside this rectangle, in pixels, end exclusive.
+    void setClip(int x0, int y0, int x1, int y1);
+    void clear(const RasterColor& c);
+
+    // Axis-aligned rectangle, with the texture (or just region of it) stretched
+    // over it when given.
+    void fillRect(float x0, float y0, float x1, float y1, const RasterColor& c, const RasterTexture* tex = nullptr,
+        const RasterRegion* region = nullptr);
+    // Colour from c0 to c1 by s = u * du + v * dv over the rectangle, clamped to 0..1.
+    void fillGradient(float x0, float y0, float x1, float y1, const RasterColor& c0, const RasterColor& c1, float du, float dv);
+    // Any parallelogram, given by corners for uv (0,0), (1,0), (1,1) and (0,1).
+    void fillQuad(const float* xs, const float* ys, const RasterColor& c, const RasterTexture* tex = nullptr,
+        const RasterRegion* region = nullptr);
+    // The part of a ring between radius r0 and r1 from angle a0 to a1 (radians,
+    // counter-clockwise on screen). A full disk is r0 0 over any full turn.
+    void fillSector(float cx, float cy, float r0, float r1, float a0, float a1, const RasterColor& c);
+    // Built-in 8x16 font, scaled so capitals are size pixels tall; x, y is
+    // the lower left corner. Returns the advance width.
+    float drawText(float x, float y, float size, const std::string& text, const RasterColor& c);
+
+    const RasterStats& getStats() const { return stats; }
+    void resetStats() { stats = RasterStats(); }
+};
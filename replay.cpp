@@ -0,0 +1,141 @@
+#include "replay.h"
+#include "moves.h"
+#include <cstring>
+
+static void putU16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void putU32(uint8_t* p, uint32_t v) { putU16(p, (uint16_t)v); putU16(p + 2, (uint16_t)(v >> 16)); }
+static uint16_t getU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t getU32(const uint8_t* p) { return getU16(p) | ((uint32_t)getU16(p + 2) << 16); }
+
+static void encodeHeader(const ReplayHeader& h, uint8_t* out) {
+    memset(out, 0, REPLAY_HEADER_SIZE);
+    memcpy(out, "KARP", 4);
+    putU16(out + 4, h.version);
+    putU16(out + 6, h.simHz);
+    putU32(out + 8, h.seed);
+    putU32(out + 12, h.tickCount);
+    uint32_t bits;
+    memcpy(&bits, &h.finalHealth[0], 4); putU32(out + 16, bits);
+    memcpy(&bits, &h.finalHealth[1], 4); putU32(out + 20, bits);
+    out[24] = (uint8_t)(h.winner + 1);
+    out[25] = h.scalarMode;
+    putU32(out + 28, h.movesHash);
+}
+
+static bool decodeHeader(const uint8_t* in, ReplayHeader& h) {
+    if (memcmp(in, "KARP", 4) != 0) return false;
+    h.version = getU16(in + 4);
+    h.simHz = getU16(in + 6);
+    h.seed = getU32(in + 8);
+    h.tickCount = getU32(in + 12);
+    uint32_t bits = getU32(in + 16); memcpy(&h.finalHealth[0], &bits, 4);
+    bits = getU32(in + 20); memcpy(&h.finalHealth[1], &bits, 4);
+    h.winner = (int)in[24] - 1;
+    h.scalarMode = in[25];
+    h.movesHash = getU32(in + 28);
+    return h.version == REPLAY_VERSION && h.simHz == SIM_HZ && h.scalarMode == SCALAR_MODE;
+}
+
+bool ReplayWriter::open(const std::string& path, uint32_t seed, const MoveTable* moves) {
+    if (file) fclose(file);
+    file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    header = ReplayHeader();
+    header.seed = seed;
+    header.movesHash = (moves ? *moves : defaultMoves()).getHash();
+    uint8_t raw[REPLAY_HEADER_SIZE];
+    encodeHeader(header, raw);
+    fwrite(raw, 1, sizeof(raw), file);
+    return true;
+}
+
+void ReplayWriter::write(const uint8_t buttons[2]) {
+    if (!file) return;
+    fputc(packReplayInput(buttons), file);
+    ++header.tickCount;
+}
+
+void ReplayWriter::close(const Simulation& result) {
+    if (!file) return;
+    const FighterStore& f = result.getFighters();
+    header.finalHealth[0] = toFloat(f.health[0]);
+    header.finalHealth[1] = toFloat(f.health[1]);
+    header.winner = result.getWinner();
+    uint8_t raw[REPLAY_HEADER_SIZE];
+    encodeHeader(header, raw);
+    fseek(file, 0, SEEK_SET);
+    fwrite(raw, 1, sizeof(raw), file);
+    fclose(file);
+    file = nullptr;
+}
+
+bool ReplayReader::open(const std::string& path) {
+    close();
+    file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    uint8_t raw[REPLAY_HEADER_SIZE];
+    if (fread(raw, 1, sizeof(raw), file) != sizeof(raw) || !decodeHeader(raw, header)) {
+        close();
+        return false;
+    }
+    position = 0;
+    return true;
+}
+
+void ReplayReader::close() {
+    if (file) fclose(file);
+    file = nullptr;
+}
+
+bool ReplayReader::seek(uint32_t tick) {
+    if (!file || tick > header.tickCount) return false;
+    if (fseek(file, REPLAY_HEADER_SIZE + (long)tick, SEEK_SET) != 0) return false;
+    position = tick;
+    return true;
+}
+
+bool ReplayReader::read(uint8_t buttons[2]) {
+    if (!file || position >= header.tickCount) return false;
+    int c = fgetc(file);
+    if (c == EOF) return false;
+    unpackReplayInput((uint8_t)c, buttons);
+    ++position;
+    return true;
+}
+
+bool ReplayPlayer::open(const std::string& path, const MoveTable* moves) {
+    if (!reader.open(path)) return false;
+    sim.setMoves(moves);
+    if (reader.getHeader().movesHash != sim.getMoves().getHash()) {
+        reader.close();
+        return false;
+    }
+    sim.reset();
+    tick = 0;
+    keyframes.clear();
+    keyframes.push_back(sim);
+    return true;
+}
+
+bool ReplayPlayer::step() {
+    uint8_t buttons[2];
+    if (!reader.read(buttons)) return false;
+    sim.update(buttons, SIM_DT);
+    ++tick;
+    if (tick % REPLAY_KEYFRAME_INTERVAL == 0 && tick / REPLAY_KEYFRAME_INTERVAL == keyframes.size())
+        keyframes.push_back(sim);
+    return true;
+}
+
+uint32_t ReplayPlayer::seek(uint32_t target) {
+    if (target > reader.getHeader().tickCount) target = reader.getHeader().tickCount;
+    if (target < tick) {
+        size_t k = target / REPLAY_KEYFRAME_INTERVAL;
+        if (k >= keyframes.size()) k = keyframes.size() - 1;
+        sim = keyframes[k];
+        tick = (uint32_t)k * REPLAY_KEYFRAME_INTERVAL;
+        reader.seek(tick);
+    }
+    while (tick < target && step()) {}
+    return tick;
+}
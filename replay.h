@@ -0,0 +1,99 @@
+#pragma once
+#include "sim.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Binary replay of a two-player match. After a fixed 32-byte header the file
+// is one byte per tick: player 1's InputBits in the low nibble, player 2's in
+// the high nibble. Tick N therefore lives at offset REPLAY_HEADER_SIZE + N and
+// files can be written and read as streams without loading them whole.
+//
+// Header, little-endian:
+//   char[4] "KARP", u16 version, u16 sim hz, u32 seed, u32 tick count,
+//   f32 final health p1, f32 final health p2, u8 winner + 1,
+//   u8 scalar mode (SCALAR_MODE of the recording build), u8[2] padding,
+//   u32 MoveTable::getHash() of the moves it was recorded with
+// The tick count and result are patched in when the writer closes. Files
+// recorded with the other scalar mode are rejected on open, and a player
+// only accepts a move table with the recorded hash.
+
+const uint16_t REPLAY_VERSION = 2;
+const int REPLAY_HEADER_SIZE = 32;
+const uint32_t REPLAY_KEYFRAME_INTERVAL = SIM_HZ * 2;
+
+struct ReplayHeader {
+    uint16_t version = REPLAY_VERSION;
+    uint16_t simHz = SIM_HZ;
+    uint32_t seed = 0;
+    uint32_t tickCount = 0;
+    float finalHealth[2] = { 0.f, 0.f };
+    int winner = -1;
+    uint8_t scalarMode = SCALAR_MODE;
+    uint32_t movesHash = 0;
+};
+
+inline uint8_t packReplayInput(const uint8_t buttons[2]) {
+    return (uint8_t)((buttons[0] & 0x0f) | ((buttons[1] & 0x0f) << 4));
+}
+
+inline void unpackReplayInput(uint8_t packed, uint8_t buttons[2]) {
+    buttons[0] = packed & 0x0f;
+    buttons[1] = packed >> 4;
+}
+
+class ReplayWriter {
+private:
+    FILE* file = nullptr;
+    ReplayHeader header;
+public:
+    ~ReplayWriter() { if (file) fclose(file); }
+
+    // moves is the table the simulation runs with; null means defaultMoves().
+    bool open(const std::string& path, uint32_t seed, const MoveTable* moves = nullptr);
+    bool isOpen() const { return file != nullptr; }
+    void write(const uint8_t buttons[2]);
+    // Records the outcome from the simulation and finalizes the header.
+    void close(const Simulation& result);
+};
+
+class ReplayReader {
+private:
+    FILE* file = nullptr;
+    ReplayHeader header;
+    uint32_t position = 0;
+public:
+    ~ReplayReader() { if (file) fclose(file); }
+
+    bool open(const std::string& path);
+    void close();
+    const ReplayHeader& getHeader() const { return header; }
+    bool seek(uint32_t tick);
+    // Reads the next tick's buttons; false at the end of the recording.
+    bool read(uint8_t buttons[2]);
+    uint32_t getPosition() const { return position; }
+};
+
+// Drives a Simulation from a replay file as fast as it can step. A snapshot
+// is kept every REPLAY_KEYFRAME_INTERVAL ticks on the way through, so
+// seeking backwards restores the nearest keyframe instead of replaying from
+// the start.
+class ReplayPlayer {
+private:
+    ReplayReader reader;
+    Simulation sim;
+    uint32_t tick = 0;
+    std::vector<Simulation> keyframes;   // keyframes[i] is the state at tick i * interval
+public:
+    // Plays with moves, or defaultMoves() when null, which must outlive the
+    // player. False when the file cannot be read or was recorded with a
+    // different move table.
+    bool open(const std::string& path, const MoveTable* moves = nullptr);
+    const ReplayHeader& getHeader() const { return reader.getHeader(); }
+    bool step();
+    // Moves to the given tick (clamped to the recording) and returns where it landed.
+    uint32_t seek(uint32_t target);
+    uint32_t playToEnd() { return seek(reader.getHeader().tickCount); }
+    const Simulation& getSim() const { return sim; }
+    uint32_t getTick() const { return tick; }
+};
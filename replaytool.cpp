@@ -0,0 +1,177 @@
+#include "bot.h"
+#include "moves.h"
+#include "replay.h"
+#include "statehash.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Replay utility.
+//   replaytool record <file> [seed]     record a bot-vs-bot match
+//   replaytool play <file>              play back headless and report speed
+//   replaytool seek <file> <tick>       jump to a tick and print fighter state
+//   replaytool verify <file>...         replay a corpus and check each
+//                                       outcome still matches its header
+//   replaytool bisect <a> <b>           replay two recordings side by side
+//                                       and report the first tick and field
+//                                       where they, or their hash logs, differ
+// Any of these can be preceded by --moves <file> to simulate with that move
+// file instead of the built-in moves; replays only play with the moves they
+// were recorded with.
+
+static MoveTable g_moves;
+
+static double secondsSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void printState(const Simulation& sim, uint32_t tick) {
+    const FighterStore& f = sim.getFighters();
+    printf("tick %u: p1 x=%.2f y=%.2f hp=%.0f  p2 x=%.2f y=%.2f hp=%.0f\n",
+        tick, toFloat(f.x[0]), toFloat(f.y[0]), toFloat(f.health[0]), toFloat(f.x[1]), toFloat(f.y[1]), toFloat(f.health[1]));
+}
+
+static int record(const char* path, uint32_t seed) {
+    ReplayWriter writer;
+    HashLogWriter hashes;
+    if (!writer.open(path, seed, &g_moves) || !hashes.open(hashLogPath(path))) { printf("cannot write %s\n", path); return 1; }
+    Rng rng(seed);
+    Simulation sim;
+    sim.setMoves(&g_moves);
+    const int maxTicks = SIM_HZ * 99;
+    int tick = 0;
+    for (; tick < maxTicks && !sim.isOver(); ++tick) {
+        uint8_t buttons[2];
+        buttons[0] = botInput(sim.getFighters(), 0, 1, rng);
+        buttons[1] = botInput(sim.getFighters(), 1, 0, rng);
+        writer.write(buttons);
+        sim.update(buttons, SIM_DT);
+        StateHash h;
+        hashState(sim, h);
+        hashes.write(h);
+    }
+    writer.close(sim);
+    hashes.close();
+    printState(sim, (uint32_t)tick);
+    return 0;
+}
+
+static int play(const char* path) {
+    ReplayPlayer player;
+    if (!player.open(path, &g_moves)) { printf("cannot read %s, or it was recorded with other moves\n", path); return 1; }
+    auto t0 = std::chrono::steady_clock::now();
+    uint32_t ticks = player.playToEnd();
+    double secs = secondsSince(t0);
+    printState(player.getSim(), ticks);
+    double matchSecs = (double)ticks / SIM_HZ;
+    printf("%u ticks in %.3f ms (%.0fx real time)\n", ticks, secs * 1e3, secs > 0 ? matchSecs / secs : 0.0);
+    return 0;
+}
+
+static int seek(const char* path, uint32_t target) {
+    ReplayPlayer player;
+    if (!player.open(path, &g_moves)) { printf("cannot read %s, or it was recorded with other moves\n", path); return 1; }
+    player.playToEnd();
+    auto t0 = std::chrono::steady_clock::now();
+    uint32_t tick = player.seek(target);
+    double secs = secondsSince(t0);
+    printState(player.getSim(), tick);
+    printf("seek back from end took %.1f us\n", secs * 1e6);
+    return 0;
+}
+
+static int verify(int count, char** paths) {
+    int failures = 0;
+    for (int i = 0; i < count; ++i) {
+        ReplayPlayer player;
+        if (!player.open(paths[i], &g_moves)) {
+            printf("FAIL %s: unreadable, wrong version, or recorded with the other scalar mode or other moves\n", paths[i]);
+            ++failures;
+            continue;
+        }
+        player.playToEnd();
+        const ReplayHeader& h = player.getHeader();
+        const FighterStore& f = player.getSim().getFighters();
+        float health[2] = { toFloat(f.health[0]), toFloat(f.health[1]) };
+        bool ok = player.getTick() == h.tickCount && health[0] == h.finalHealth[0] &&
+            health[1] == h.finalHealth[1] && player.getSim().getWinner() == h.winner;
+        printf("%s %s: %u ticks, hp %.0f/%.0f (recorded %.0f/%.0f)\n", ok ? "ok  " : "FAIL",
+            paths[i], player.getTick(), health[0], health[1], h.finalHealth[0], h.finalHealth[1]);
+        if (!ok) ++failures;
+    }
+    printf("%d of %d replays match\n", count - failures, count);
+    return failures ? 1 : 0;
+}
+
+static int bisect(const char* pathA, const char* pathB) {
+    ReplayReader replays[2];
+    HashLogReader logs[2];
+    const char* paths[2] = { pathA, pathB };
+    bool haveLog[2];
+    for (int i = 0; i < 2; ++i) {
+        if (!replays[i].open(paths[i])) { printf("cannot read %s\n", paths[i]); return 1; }
+        if (replays[i].getHeader().movesHash != g_moves.getHash()) { printf("%s was recorded with other moves\n", paths[i]); return 1; }
+        haveLog[i] = logs[i].open(hashLogPath(paths[i]));
+        if (!haveLog[i]) printf("%s: no hash log, comparing replayed states only\n", paths[i]);
+    }
+
+    Simulation sims[2];
+    for (Simulation& s : sims) s.setMoves(&g_moves);
+    int64_t inputsDiffer = -1;
+    uint32_t tick = 0;
+    for (;; ++tick) {
+        uint8_t buttons[2][2];
+        if (!replays[0].read(buttons[0]) || !replays[1].read(buttons[1])) break;
+        if (inputsDiffer < 0 && memcmp(buttons[0], buttons[1], 2) != 0) inputsDiffer = tick;
+        StateHash local[2], logged[2];
+        for (int i = 0; i < 2; ++i) {
+            sims[i].update(buttons[i], SIM_DT);
+            hashState(sims[i], local[i]);
+            if (haveLog[i] && !logs[i].read(logged[i])) haveLog[i] = false;
+        }
+
+        // The logs are what each machine computed; disagreeing with a replay
+        // of its own inputs means that machine's simulation went its own way.
+        bool logsDiffer = haveLog[0] && haveLog[1] && logged[0] != logged[1];
+        bool strayed[2] = { haveLog[0] && logged[0] != local[0], haveLog[1] && logged[1] != local[1] };
+        if (!logsDiffer && !strayed[0] && !strayed[1] && local[0] == local[1]) continue;
+
+        printf("first difference at tick %u\n", tick);
+        if (inputsDiffer >= 0) printf("  inputs first differ at tick %lld\n", (long long)inputsDiffer);
+        if (logsDiffer)
+            printf("  hash logs differ in %s\n", stateFieldName(logged[0].firstDifference(logged[1])));
+        for (int i = 0; i < 2; ++i) {
+            if (strayed[i])
+                printf("  %s: logged %s does not match replaying it here\n", paths[i],
+                    stateFieldName(logged[i].firstDifference(local[i])));
+        }
+        std::string diff = describeDifference(sims[0], sims[1]);
+        if (!diff.empty()) printf("  replayed states differ: %s\n", diff.c_str());
+        printState(sims[0], tick);
+        printState(sims[1], tick);
+        return 1;
+    }
+    printf("no difference in %u ticks\n", tick);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && strcmp(argv[1], "--moves") == 0) {
+        if (!g_moves.load(argv[2])) { printf("%s\n", g_moves.getError().c_str()); return 1; }
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc >= 3 && strcmp(argv[1], "record") == 0)
+        return record(argv[2], argc > 3 ? (uint32_t)strtoul(argv[3], nullptr, 10) : 1u);
+    if (argc >= 3 && strcmp(argv[1], "play") == 0)
+        return play(argv[2]);
+    if (argc >= 4 && strcmp(argv[1], "seek") == 0)
+        return seek(argv[2], (uint32_t)strtoul(argv[3], nullptr, 10));
+    if (argc >= 3 && strcmp(argv[1], "verify") == 0)
+        return verify(argc - 2, argv + 2);
+    if (argc >= 4 && strcmp(argv[1], "bisect") == 0)
+        return bisect(argv[2], argv[3]);
+    printf("usage: replaytool [--moves <file>] record <file> [seed] | play <file> | seek <file> <tick> | verify <file>... | bisect <a> <b>\n");
+    return 1;
+}
@@ -0,0 +1,172 @@
+#include "rollback.h"
+
+void RollbackSession::reset(int slot) {
+    localSlot = slot;
+    sim.reset();
+    frame = 0;
+    confirmedRemote = -1;
+    rollbackFrom = -1;
+    lastRemote = 0;
+    rollbacks = resimulatedFrames = maxResimulated = 0;
+    for (int i = 0; i < ROLLBACK_HISTORY; ++i)
+        inputs[0][i] = inputs[1][i] = 0;
+}
+
+void RollbackSession::step() {
+    int idx = frame % ROLLBACK_HISTORY;
+    int remote = 1 - localSlot;
+    if (frame > confirmedRemote) inputs[remote][idx] = lastRemote;
+    snapshots[idx] = sim;
+    uint8_t buttons[2] = { inputs[0][idx], inputs[1][idx] };
+    sim.update(buttons, SIM_DT);
+    ++frame;
+}
+
+void RollbackSession::applyRollback() {
+    if (rollbackFrom < 0) return;
+    int32_t target = frame;
+    int count = target - rollbackFrom;
+    sim = snapshots[rollbackFrom % ROLLBACK_HISTORY];
+    frame = rollbackFrom;
+    while (frame < target) step();
+    rollbackFrom = -1;
+
+    ++rollbacks;
+    resimulatedFrames += count;
+    if (count > maxResimulated) maxResimulated = count;
+}
+
+bool RollbackSession::advance(uint8_t localButtons) {
+    if (!canAdvance()) return false;
+    applyRollback();
+    inputs[localSlot][frame % ROLLBACK_HISTORY] = localButtons;
+    step();
+    return true;
+}
+
+int32_t RollbackSession::getLastConfirmedFrame() const {
+    int32_t last = frame - 1 < confirmedRemote ? frame - 1 : confirmedRemote;
+    if (rollbackFrom >= 0 && rollbackFrom - 1 < last) last = rollbackFrom - 1;
+    return last;
+}
+
+const Simulation* RollbackSession::getConfirmedState(int32_t f) const {
+    if (f < 0 || f > getLastConfirmedFrame() || f < frame - ROLLBACK_HISTORY) return nullptr;
+    return f + 1 == frame ? &sim : &snapshots[(f + 1) % ROLLBACK_HISTORY];
+}
+
+void RollbackSession::addRemoteInput(int32_t f, uint8_t buttons) {
+    if (f != confirmedRemote + 1) return;
+    // Inputs from the peer can only run ROLLBACK_WINDOW frames past our own frame.
+    if (f >= frame + ROLLBACK_HISTORY - ROLLBACK_WINDOW) return;
+    int idx = f % ROLLBACK_HISTORY;
+    uint8_t& slot = inputs[1 - localSlot][idx];
+    if (f < frame && slot != buttons && (rollbackFrom < 0 || f < rollbackFrom))
+        rollbackFrom = f;
+    slot = buttons;
+    confirmedRemote = f;
+    lastRemote = buttons;
+}
+
+// Packet layout, little-endian:
+//   u32 first frame, u32 ack (last remote frame we confirmed), u8 count, count x u8 buttons,
+//   u32 last hashed frame, u8 hash count, hash count x u32 hashes ending at that frame
+static const int MAX_PACKET_INPUTS = 24;
+static const int MAX_PACKET_HASHES = 4;
+
+static void writeU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t readU32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool NetplaySession::start(int localSlot, uint16_t localPort, const char* host, uint16_t remotePort) {
+    NetAddress remote;
+    if (!resolveAddress(host, remotePort, remote)) return false;
+    rollback.reset(localSlot);
+    peerAck = -1;
+    hashedFrame = peerHashedFrame = checkedFrame = desyncFrame = -1;
+    checkedHashes = 0;
+    for (int i = 0; i < ROLLBACK_HISTORY; ++i) peerHashFrames[i] = -1;
+    return link.open(localPort, remote);
+}
+
+void NetplaySession::sendInputs(double nowMs) {
+    int32_t end = rollback.getFrame();
+    int32_t first = peerAck + 1;
+    if (end - first > MAX_PACKET_INPUTS) first = end - MAX_PACKET_INPUTS;
+    if (first < 0) first = 0;
+
+    uint8_t packet[9 + MAX_PACKET_INPUTS + 5 + 4 * MAX_PACKET_HASHES];
+    writeU32(packet, (uint32_t)first);
+    writeU32(packet + 4, (uint32_t)rollback.getConfirmedRemote());
+    packet[8] = (uint8_t)(end - first);
+    for (int32_t f = first; f < end; ++f)
+        packet[9 + (f - first)] = rollback.getLocalInput(f);
+    uint8_t* tail = packet + 9 + (end - first);
+    int hashCount = hashedFrame + 1 < MAX_PACKET_HASHES ? hashedFrame + 1 : MAX_PACKET_HASHES;
+    writeU32(tail, (uint32_t)hashedFrame);
+    tail[4] = (uint8_t)hashCount;
+    for (int i = 0; i < hashCount; ++i)
+        writeU32(tail + 5 + i * 4, (uint32_t)getHash(hashedFrame - hashCount + 1 + i).combined);
+    link.send(packet, (int)(tail + 5 + hashCount * 4 - packet), nowMs);
+}
+
+void NetplaySession::hashConfirmed() {
+    int32_t last = rollback.getLastConfirmedFrame();
+    while (hashedFrame < last) {
+        ++hashedFrame;
+        hashState(*rollback.getConfirmedState(hashedFrame), hashes[hashedFrame % ROLLBACK_HISTORY]);
+    }
+}
+
+void NetplaySession::checkHashes() {
+    while (checkedFrame < hashedFrame && checkedFrame + 1 <= peerHashedFrame) {
+        int32_t f = checkedFrame + 1;
+        int idx = f % ROLLBACK_HISTORY;
+        // Frames whose hash never arrived, or whose own hash is already gone, are skipped.
+        if (peerHashFrames[idx] == f && f > hashedFrame - ROLLBACK_HISTORY) {
+            if (peerHashes[idx] != (uint32_t)hashes[idx].combined && desyncFrame < 0) desyncFrame = f;
+            ++checkedHashes;
+        }
+        checkedFrame = f;
+    }
+}
+
+void NetplaySession::poll(double nowMs) {
+    uint8_t packet[256];
+    int n;
+    while ((n = link.receive(packet, sizeof(packet))) >= 9) {
+        int32_t first = (int32_t)readU32(packet);
+        int32_t ack = (int32_t)readU32(packet + 4);
+        int count = packet[8];
+        if (9 + count + 5 > n) continue;
+        const uint8_t* tail = packet + 9 + count;
+        int hashCount = tail[4];
+        if (9 + count + 5 + hashCount * 4 > n || hashCount > MAX_PACKET_HASHES) continue;
+        if (ack > peerAck) peerAck = ack;
+        for (int i = 0; i < count; ++i)
+            rollback.addRemoteInput(first + i, packet[9 + i]);
+        int32_t last = (int32_t)readU32(tail);
+        for (int i = 0; i < hashCount; ++i) {
+            int32_t f = last - hashCount + 1 + i;
+            if (f < 0) continue;
+            peerHashes[f % ROLLBACK_HISTORY] = readU32(tail + 5 + i * 4);
+            peerHashFrames[f % ROLLBACK_HISTORY] = f;
+        }
+        if (last > peerHashedFrame) peerHashedFrame = last;
+    }
+    link.flush(nowMs);
+    hashConfirmed();
+    checkHashes();
+}
+
+bool NetplaySession::advance(uint8_t localButtons, double nowMs) {
+    bool stepped = rollback.advance(localButtons);
+    hashConfirmed();
+    checkHashes();
+    sendInputs(nowMs);
+    return stepped;
+}
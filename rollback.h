@@ -0,0 +1,97 @@
+#pragma once
+#include "net.h"
+#include "sim.h"
+#include "statehash.h"
+
+// GGPO-style rollback for a two-player match. Every simulated frame saves a
+// snapshot of the Simulation. Remote input that has not arrived yet is
+// predicted by repeating the last confirmed one. When a late input differs
+// from the prediction, the session restores the snapshot of that frame and
+// resimulates up to the present.
+
+const int ROLLBACK_WINDOW = 8;    // max frames local play may run ahead of confirmed remote input
+const int ROLLBACK_HISTORY = 32;  // ring size for inputs and snapshots, must exceed the window
+
+class RollbackSession {
+private:
+    Simulation sim;
+    Simulation snapshots[ROLLBACK_HISTORY];      // state at the start of frame f, at f % ROLLBACK_HISTORY
+    uint8_t inputs[2][ROLLBACK_HISTORY] = {};    // buttons used for frame f
+    int localSlot = 0;
+    int32_t frame = 0;              // next frame to simulate
+    int32_t confirmedRemote = -1;   // last frame with contiguous confirmed remote input
+    int32_t rollbackFrom = -1;      // earliest frame simulated with a wrong prediction
+    uint8_t lastRemote = 0;
+    int rollbacks = 0, resimulatedFrames = 0, maxResimulated = 0;
+
+    void step();
+public:
+    explicit RollbackSession(int slot = 0) { reset(slot); }
+
+    void reset(int slot);
+    bool canAdvance() const { return frame - (confirmedRemote + 1) < ROLLBACK_WINDOW; }
+    // Simulates the next frame with the given local buttons. Returns false
+    // without stepping when too far ahead of the remote peer.
+    bool advance(uint8_t localButtons);
+    // Remote input must be fed in frame order; duplicates and gaps are ignored.
+    void addRemoteInput(int32_t f, uint8_t buttons);
+    // Restores and resimulates if a misprediction is pending. advance() calls this itself.
+    void applyRollback();
+
+    const Simulation& getSim() const { return sim; }
+    int getLocalSlot() const { return localSlot; }
+    int32_t getFrame() const { return frame; }
+    int32_t getConfirmedRemote() const { return confirmedRemote; }
+    uint8_t getLocalInput(int32_t f) const { return inputs[localSlot][f % ROLLBACK_HISTORY]; }
+    uint8_t getInput(int slot, int32_t f) const { return inputs[slot][f % ROLLBACK_HISTORY]; }
+    // Last frame simulated with confirmed input from both sides and no rollback pending.
+    int32_t getLastConfirmedFrame() const;
+    // State after frame f, or nullptr unless f is confirmed and still in the history.
+    const Simulation* getConfirmedState(int32_t f) const;
+    int getRollbacks() const { return rollbacks; }
+    int getResimulatedFrames() const { return resimulatedFrames; }
+    int getMaxResimulated() const { return maxResimulated; }
+};
+
+// RollbackSession wired to a peer over UDP. Each packet carries every local
+// input the peer has not acknowledged yet, so a lost packet is covered by
+// the next one. Each confirmed frame is hashed once (statehash.h), and every
+// packet also carries the low 32 bits of the last few of those hashes; a
+// frame whose hash differs from the peer's is reported as the desync frame.
+class NetplaySession {
+private:
+    RollbackSession rollback;
+    UdpLink link;
+    int32_t peerAck = -1;   // last of our frames the peer has confirmed
+    StateHash hashes[ROLLBACK_HISTORY];          // state after frame f, at f % ROLLBACK_HISTORY
+    int32_t hashedFrame = -1;                    // last frame in hashes
+    uint32_t peerHashes[ROLLBACK_HISTORY] = {};
+    int32_t peerHashFrames[ROLLBACK_HISTORY];    // frame each peerHashes entry is for
+    int32_t peerHashedFrame = -1;
+    int32_t checkedFrame = -1;                   // last frame compared or skipped
+    int32_t desyncFrame = -1;
+    int checkedHashes = 0;
+
+    void hashConfirmed();
+    void checkHashes();
+public:
+    bool start(int localSlot, uint16_t localPort, const char* host, uint16_t remotePort);
+    void setConditions(double latencyMs, int lossPercent, uint32_t seed) {
+        link.setConditions(latencyMs, lossPercent, seed);
+    }
+    // Reads pending packets and releases delayed ones.
+    void poll(double nowMs);
+    // Steps one frame if the rollback window allows it, then sends inputs either way.
+    bool advance(uint8_t localButtons, double nowMs);
+    void sendInputs(double nowMs);
+
+    RollbackSession& getRollback() { return rollback; }
+    const Simulation& getSim() const { return rollback.getSim(); }
+    UdpLink& getLink() { return link; }
+    int32_t getHashedFrame() const { return hashedFrame; }
+    // Hash of the state after a confirmed frame, for the last ROLLBACK_HISTORY of them.
+    const StateHash& getHash(int32_t f) const { return hashes[f % ROLLBACK_HISTORY]; }
+    // First frame where the peer's state differed from ours, or -1.
+    int32_t getDesyncFrame() const { return desyncFrame; }
+    int getCheckedHashes() const { return checkedHashes; }
+};
@@ -0,0 +1,253 @@
+#include "audio.h"
+#include "bot.h"
+#include "crowd.h"
+#include "input.h"
+#include "moves.h"
+#include "pack.h"
+#include "pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+// Checks of what the replays and the loopback run cannot catch, because the
+// shipped moves and assets never exercise it. Prints each failure and exits
+// non-zero if there was one.
+// Usage: selftest
+
+static int failures = 0;
+
+static void expect(bool ok, const char* what) {
+    if (!ok) {
+        printf("FAILED: %s\n", what);
+        ++failures;
+    }
+}
+
+// A jab that only reaches ahead of the attacker, 20 to 60 pixels out.
+static const char* const JAB_MOVES =
+    "move jab\n"
+    "input punch\n"
+    "active 5\n"
+    "recovery 10\n"
+    "hitbox 20 60 -1000 1000\n"
+    "damage 10\n";
+
+// Health the target has left after the attacker, at attackerX, jabs it at targetX.
+static float jabDuel(const MoveTable& moves, FighterHandle attacker, float attackerX, float targetX) {
+    FighterStore f;
+    FighterHandle target = 1 - attacker;
+    for (FighterHandle h = 0; h < 2; ++h) f.add(h == attacker ? attackerX : targetX, 0.f);
+    f.moveFrame[attacker] = moves.getFirstFrame(moves.find("jab"));
+    checkHit(f, attacker, target, moves);
+    return toFloat(f.health[target]);
+}
+
+static void testHitboxFacing() {
+    MoveTable moves;
+    expect(moves.parse(JAB_MOVES), "jab moves parse");
+    // Each slot, with its opponent on either side: in front is a hit, and so
+    // is the mirrored box; too close is inside the gap on both sides.
+    for (FighterHandle a = 0; a < 2; ++a) {
+        expect(jabDuel(moves, a, 300.f, 340.f) == 90.f, "jab hits an opponent 40 to the right");
+        expect(jabDuel(moves, a, 340.f, 300.f) == 90.f, "jab hits an opponent 40 to the left");
+        expect(jabDuel(moves, a, 300.f, 310.f) == 100.f, "jab misses an opponent 10 to the right");
+        expect(jabDuel(moves, a, 310.f, 300.f) == 100.f, "jab misses an opponent 10 to the left");
+        expect(jabDuel(moves, a, 300.f, 380.f) == 100.f, "jab misses an opponent 80 to the right");
+    }
+
+    // Crowd mode: the middle fighter is nearer its left neighbour, so it
+    // faces and hits that one only.
+    CrowdSimulation crowd;
+    crowd.setMoves(&moves);
+    crowd.reset(3);
+    FighterStore& f = crowd.getFighters();
+    f.x[0] = 300.f;
+    f.x[1] = 340.f;
+    f.x[2] = 400.f;
+    uint8_t buttons[3] = { 0, INPUT_PUNCH, 0 };
+    crowd.update(buttons, 0.f);
+    expect(toFloat(f.health[0]) == 90.f, "crowd jab hits the nearer neighbour on the left");
+    expect(toFloat(f.health[2]) == 100.f, "crowd jab misses the neighbour behind");
+}
+
+// Counts how many are alive, to catch a pool that skips a constructor or destructor.
+struct Counted {
+    static int alive;
+    int value;
+    explicit Counted(int v) : value(v) { ++alive; }
+    ~Counted() { --alive; }
+};
+int Counted::alive = 0;
+
+static bool poolHolds(const ObjectPool<Counted>& pool, std::vector<int> values) {
+    std::vector<int> held;
+    for (Counted* c : pool) held.push_back(c->value);
+    std::sort(held.begin(), held.end());
+    std::sort(values.begin(), values.end());
+    return held == values;
+}
+
+static void testObjectPool() {
+    {
+        ObjectPool<Counted> pool(4);
+        Counted* objs[4];
+        for (int i = 0; i < 4; ++i) objs[i] = pool.spawn(i);
+        expect(pool.isFull() && pool.size() == 4 && Counted::alive == 4, "pool spawns up to its capacity");
+        expect(pool.spawn(9) == nullptr && Counted::alive == 4, "a full pool spawns nothing");
+        expect(poolHolds(pool, { 0, 1, 2, 3 }), "pool iterates every live object");
+
+        pool.despawn(objs[1]);
+        expect(pool.size() == 3 && !pool.isFull() && Counted::alive == 3, "despawn destroys the object");
+        expect(poolHolds(pool, { 0, 2, 3 }), "despawn keeps the others iterable");
+        Counted* again = pool.spawn(7);
+        expect(again == objs[1] && again->value == 7, "spawn reuses the freed slot");
+        pool.despawn(objs[3]);
+        pool.despawn(objs[0]);
+        expect(poolHolds(pool, { 2, 7 }), "despawning the last and first live objects");
+        pool.clear();
+        expect(pool.size() == 0 && Counted::alive == 0, "clear destroys every live object");
+        for (int i = 0; i < 3; ++i) pool.spawn(10 + i);
+    }
+    expect(Counted::alive == 0, "the pool's destructor destroys its live objects");
+}
+
+// A pack with one RGBA8 entry of 16 bytes that claims to be width x height.
+static bool openImagePack(const std::string& path, uint32_t width, uint32_t height) {
+    static const uint8_t texels[16] = {};
+    PackInput in = { "image.png", 0, PackFormat::RGBA8, width, height, texels, sizeof(texels) };
+    PackFile pack;
+    return writePack(path, std::vector<PackInput>(1, in)) && pack.open(path);
+}
+
+static void testPackBounds() {
+    std::string path = (std::filesystem::temp_directory_path() / "kombat_selftest.kpak").string();
+    expect(openImagePack(path, 2, 2), "pack with a 2x2 image opens");
+    expect(!openImagePack(path, 3, 2), "pack with an image larger than its data is rejected");
+    expect(!openImagePack(path, 0x80000000u, 0x80000000u), "pack with an image size that overflows is rejected");
+    expect(!openImagePack(path, 0, 4), "pack with an empty image is rejected");
+    std::filesystem::remove(path);
+}
+
+static bool testKeys[INPUT_MAX_KEYS];
+static bool testKeyDown(int key) { return testKeys[key]; }
+
+// Netplay peeks at a tick's buttons and only records them if the tick runs.
+static void testInputPeek() {
+    InputBindings keys;
+    expect(keys.parse("p1 punch g\np1 jump w\np2 punch rctrl\nbuffer 8 punch jump\n"), "test bindings parse");
+    InputSystem input;
+    input.setBindings(keys);
+    Rng rng(0x5eedu);
+    bool same = true, buffered = false;
+    for (int frame = 0; frame < 5000; ++frame) {
+        for (const InputBinding& b : input.getBindings().getBindings()) testKeys[b.key] = rng.next() % 4 == 0;
+        input.poll(testKeyDown);
+        uint8_t peeked[INPUT_PLAYERS], ticked[INPUT_PLAYERS];
+        input.peekInput(peeked);
+        // Stalled ticks peek again without recording.
+        if (rng.next() % 3 == 0) continue;
+        input.tickInput(ticked);
+        for (int p = 0; p < INPUT_PLAYERS; ++p) {
+            if (peeked[p] != ticked[p]) same = false;
+            if (ticked[p] != input.getButtons(p)) buffered = true;
+            if (rng.next() % 8 == 0) input.moveStarted(p);
+        }
+    }
+    expect(same, "peekInput gives the buttons tickInput then records");
+    expect(buffered, "the input run buffers some presses");
+}
+
+// Stereo 16-bit 44.1 kHz WAV of frames frames; frame i holds sample(i) in both channels.
+static bool writeWav(const std::string& path, uint32_t frames, int16_t (*sample)(uint32_t)) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    uint32_t dataBytes = frames * 4, riffBytes = 36 + dataBytes, fmtBytes = 16, rate = AUDIO_RATE, byteRate = AUDIO_RATE * 4;
+    uint16_t format = 1, channels = 2, align = 4, bits = 16;
+    fwrite("RIFF", 1, 4, f);
+    fwrite(&riffBytes, 4, 1, f);
+    fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmtBytes, 4, 1, f);
+    fwrite(&format, 2, 1, f);
+    fwrite(&channels, 2, 1, f);
+    fwrite(&rate, 4, 1, f);
+    fwrite(&byteRate, 4, 1, f);
+    fwrite(&align, 2, 1, f);
+    fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f);
+    fwrite(&dataBytes, 4, 1, f);
+    for (uint32_t i = 0; i < frames; ++i) {
+        int16_t s[2] = { sample(i), sample(i) };
+        fwrite(s, 2, 2, f);
+    }
+    return fclose(f) == 0;
+}
+
+// Not a multiple of the block size, so the loop wraps mid-block.
+static const uint32_t MUSIC_FRAMES = 10000;
+
+static int16_t musicRamp(uint32_t i) { return (int16_t)(1 + i % 1000); }
+static int16_t musicTone(uint32_t) { return 8000; }
+
+static void testMusicStream() {
+    std::string path = (std::filesystem::temp_directory_path() / "kombat_selftest.wav").string();
+
+    // Sample by sample as the audio thread sees it, paced a little faster
+    // than real time: the loop must carry on from frame 0 with no gap.
+    expect(writeWav(path, MUSIC_FRAMES, musicRamp), "write the ramp WAV");
+    {
+        MusicStream music;
+        expect(music.open(path, true), "open the ramp WAV looping");
+        int32_t mix[AUDIO_BLOCK * 2];
+        bool same = true;
+        for (uint32_t frame = 0; frame < 3 * MUSIC_FRAMES; frame += AUDIO_BLOCK) {
+            memset(mix, 0, sizeof(mix));
+            music.mixInto(mix, AUDIO_BLOCK, 1 << 15);
+            for (int i = 0; i < AUDIO_BLOCK; ++i)
+                if (mix[i * 2] != musicRamp((frame + i) % MUSIC_FRAMES) || mix[i * 2 + 1] != mix[i * 2]) same = false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        expect(same, "looping music wraps to its first frame");
+        expect(music.getUnderruns() == 0, "looping music read directly never underruns");
+    }
+
+    // Through the mixer and the null sink in real time, three times round.
+    expect(writeWav(path, MUSIC_FRAMES, musicTone), "write the tone WAV");
+    {
+        AudioMixer mixer;
+        NullAudioSink sink;
+        expect(mixer.getMusic().open(path, true), "open the tone WAV looping");
+        sink.start(mixer);
+        std::this_thread::sleep_for(std::chrono::milliseconds(3 * MUSIC_FRAMES * 1000 / AUDIO_RATE));
+        sink.stop();
+        expect(sink.getFrames() >= 2 * MUSIC_FRAMES, "null sink mixes in real time");
+        expect(mixer.getMusic().isPlaying(), "looping music is still playing after its length");
+        expect(mixer.getMusic().getUnderruns() == 0, "music through the null sink never underruns");
+        expect(sink.getPeak() == 8000, "null sink hears the music");
+    }
+    {
+        AudioMixer mixer;
+        NullAudioSink sink;
+        expect(mixer.getMusic().open(path, false), "open the tone WAV once");
+        sink.start(mixer);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2 * MUSIC_FRAMES * 1000 / AUDIO_RATE));
+        sink.stop();
+        expect(!mixer.getMusic().isPlaying(), "music played once ends");
+    }
+    std::filesystem::remove(path);
+}
+
+int main() {
+    testHitboxFacing();
+    testObjectPool();
+    testPackBounds();
+    testInputPeek();
+    testMusicStream();
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,470 @@
+#include "softgfx.h"
+#include "png.h"
+#include "spritebatch.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+// graphics.h over the software Rasterizer. Link this (with raster.cpp and
+// png.cpp) instead of lib/sgg.lib. Differences from SGG: textures are
+// sampled nearest and only on rectangles, text uses one built-in font
+// whatever setFont() loads, and text is neither rotated nor drawn with
+// gradients.
+
+namespace {
+
+struct SoftSprite {
+    std::string image;                    // empty for a flat colour
+    int col = 0, row = 0, cols = 1, rows = 1;
+    RasterColor color;
+    bool resolved = false;
+    // Filled in on first draw: the texture to sample, null for no texture.
+    const RasterTexture* texture = nullptr;
+    RasterRegion region;
+};
+
+struct SoftState {
+    Rasterizer raster;
+    int windowWidth = 0, windowHeight = 0;
+    float canvasWidth = 0.f, canvasHeight = 0.f;
+    graphics::scale_mode_t scaleMode = graphics::CANVAS_SCALE_WINDOW;
+    // Canvas units to framebuffer pixels.
+    float scaleX = 1.f, scaleY = 1.f, offsetX = 0.f, offsetY = 0.f;
+    RasterColor background;
+    std::function<void()> draw;
+    std::function<void(float)> update;
+    std::function<void(int, int)> resize;
+    const void* userData = nullptr;
+    float angle = 0.f, poseX = 1.f, poseY = 1.f;
+    std::unordered_map<std::string, RasterTexture> textures;
+    SoftImageSource imageSource = nullptr;
+    void* imageUser = nullptr;
+    std::vector<SoftSprite> sprites;
+    RasterTexture atlas;
+    // Where each image copied into the atlas starts.
+    std::unordered_map<const RasterTexture*, std::pair<int, int>> atlasPlaces;
+    bool hasFont = false;
+    bool running = false;
+    int frameLimit = -1;
+    float frameMs = 1000.f / 60.f;
+    double timeMs = 0.0;
+    bool keys[graphics::NUM_SCANCODES] = {};
+    graphics::MouseState mouse = {};
+};
+
+SoftState soft;
+
+void updateTransform() {
+    float w = (float)soft.windowWidth, h = (float)soft.windowHeight;
+    if (soft.scaleMode == graphics::CANVAS_SCALE_WINDOW || soft.canvasWidth <= 0.f || soft.canvasHeight <= 0.f) {
+        soft.scaleX = soft.scaleY = 1.f;
+        soft.offsetX = soft.offsetY = 0.f;
+    }
+    else if (soft.scaleMode == graphics::CANVAS_SCALE_STRETCH) {
+        soft.scaleX = w / soft.canvasWidth;
+        soft.scaleY = h / soft.canvasHeight;
+        soft.offsetX = soft.offsetY = 0.f;
+    }
+    else {
+        soft.scaleX = soft.scaleY = std::min(w / soft.canvasWidth, h / soft.canvasHeight);
+        soft.offsetX = (w - soft.canvasWidth * soft.scaleX) * 0.5f;
+        soft.offsetY = (h - soft.canvasHeight * soft.scaleY) * 0.5f;
+    }
+}
+
+float toPixelX(float x) { return soft.offsetX + x * soft.scaleX; }
+float toPixelY(float y) { return soft.offsetY + y * soft.scaleY; }
+
+std::string nativePath(std::string path) {
+#ifndef _WIN32
+    std::replace(path.begin(), path.end(), '\\', '/');
+#endif
+    return path;
+}
+
+// Loaded on first use and kept, from the image source when it has the
+// pixels; a missing file caches an empty texture so the shape is drawn in
+// its fill colour.
+const RasterTexture* getTexture(const std::string& path) {
+    if (path.empty()) return nullptr;
+    auto it = soft.textures.find(path);
+    if (it != soft.textures.end()) return &it->second;
+    RasterTexture& tex = soft.textures[path];
+    const uint8_t* rgba = nullptr;
+    int width = 0, height = 0;
+    Image image;
+    if (soft.imageSource && soft.imageSource(soft.imageUser, path, rgba, width, height))
+        makeRasterTexture(rgba, width, height, tex);
+    else if (loadPng(nativePath(path), image))
+        makeRasterTexture(image.rgba.data(), image.width, image.height, tex);
+    return &tex;
+}
+
+bool regionOpaque(const RasterTexture& tex, const RasterRegion& r) {
+    for (int y = r.y; y < r.y + r.height; ++y)
+        for (int x = r.x; x < r.x + r.width; ++x)
+            if (tex.texels[(size_t)y * tex.width + x] >> 24 != 255) return false;
+    return true;
+}
+
+// Points the sprite at its cell, in the atlas when its image was copied there.
+void resolveSprite(SoftSprite& s) {
+    s.resolved = true;
+    s.texture = nullptr;
+    const RasterTexture* image = getTexture(s.image);
+    if (!image || image->texels.empty()) return;
+    int cellWidth = image->width / s.cols, cellHeight = image->height / s.rows;
+    s.region.x = s.col * cellWidth;
+    s.region.y = s.row * cellHeight;
+    s.region.width = cellWidth;
+    s.region.height = cellHeight;
+    s.region.opaque = regionOpaque(*image, s.region);
+    s.texture = image;
+    auto placed = soft.atlasPlaces.find(image);
+    if (placed != soft.atlasPlaces.end()) {
+        s.region.x += placed->second.first;
+        s.region.y += placed->second.second;
+        s.texture = &soft.atlas;
+    }
+}
+
+RasterColor fillColor(const graphics::Brush& br) {
+    RasterColor c;
+    c.r = br.fill_color[0];
+    c.g = br.fill_color[1];
+    c.b = br.fill_color[2];
+    c.a = br.fill_opacity;
+    return c;
+}
+
+RasterColor outlineColor(const graphics::Brush& br) {
+    RasterColor c;
+    c.r = br.outline_color[0];
+    c.g = br.outline_color[1];
+    c.b = br.outline_color[2];
+    c.a = br.outline_opacity;
+    return c;
+}
+
+// Canvas point rotated by the current orientation about a pivot, in pixels.
+void posePoint(float px, float py, float dx, float dy, float& outX, float& outY) {
+    float rad = soft.angle * 0.0174532925f;
+    float c = std::cos(rad), s = std::sin(rad);
+    // Counter-clockwise on a y-down canvas.
+    outX = toPixelX(px + dx * c + dy * s);
+    outY = toPixelY(py - dx * s + dy * c);
+}
+
+// A line of the given pixel width between two pixel positions.
+void strokeSegment(float x0, float y0, float x1, float y1, float width, const RasterColor& c) {
+    float dx = x1 - x0, dy = y1 - y0;
+    float len = std::sqrt(dx * dx + dy * dy);
+    if (len <= 0.f || width <= 0.f || c.a <= 0.f) return;
+    float nx = -dy / len * width * 0.5f, ny = dx / len * width * 0.5f;
+    float xs[4] = { x0 + nx, x1 + nx, x1 - nx, x0 - nx };
+    float ys[4] = { y0 + ny, y1 + ny, y1 - ny, y0 - ny };
+    soft.raster.fillQuad(xs, ys, c);
+}
+
+}
+
+void softSetFrameLimit(int frames) { soft.frameLimit = frames; }
+void softSetFrameTime(float ms) { soft.frameMs = ms; }
+void softSetKey(graphics::scancode_t key, bool down) { soft.keys[key] = down; }
+void softSetMouse(const graphics::MouseState& ms) { soft.mouse = ms; }
+void softSetImageSource(SoftImageSource source, void* user) {
+    soft.imageSource = source;
+    soft.imageUser = user;
+}
+const Rasterizer& softGetRasterizer() { return soft.raster; }
+void softResetStats() { soft.raster.resetStats(); }
+
+uint16_t softAddSprite(const std::string& image, int col, int row, int cols, int rows) {
+    SoftSprite s;
+    s.image = image;
+    s.col = col;
+    s.row = row;
+    s.cols = cols;
+    s.rows = rows;
+    soft.sprites.push_back(s);
+    return (uint16_t)(soft.sprites.size() - 1);
+}
+
+uint16_t softAddColorSprite(float r, float g, float b) {
+    SoftSprite s;
+    s.color.r = r;
+    s.color.g = g;
+    s.color.b = b;
+    soft.sprites.push_back(s);
+    return (uint16_t)(soft.sprites.size() - 1);
+}
+
+void softBuildAtlas(int maxWidth) {
+    std::vector<const RasterTexture*> images;
+    for (const SoftSprite& s : soft.sprites) {
+        const RasterTexture* image = getTexture(s.image);
+        if (image && !image->texels.empty() && std::find(images.begin(), images.end(), image) == images.end())
+            images.push_back(image);
+    }
+    // Shelf packing, tallest first.
+    std::sort(images.begin(), images.end(), [](const RasterTexture* a, const RasterTexture* b) {
+        return a->height > b->height;
+    });
+    soft.atlasPlaces.clear();
+    int penX = 0, penY = 0, shelfHeight = 0, width = 0;
+    for (const RasterTexture* image : images) {
+        if (penX + image->width > maxWidth && penX > 0) {
+            penY += shelfHeight;
+            penX = 0;
+            shelfHeight = 0;
+        }
+        soft.atlasPlaces[image] = std::make_pair(penX, penY);
+        penX += image->width;
+        shelfHeight = std::max(shelfHeight, image->height);
+        width = std::max(width, penX);
+    }
+
+    RasterTexture& atlas = soft.atlas;
+    atlas.width = width;
+    atlas.height = penY + shelfHeight;
+    atlas.texels.assign((size_t)atlas.width * atlas.height, 0);
+    atlas.opaque = false;
+    for (const RasterTexture* image : images) {
+        std::pair<int, int> at = soft.atlasPlaces[image];
+        for (int y = 0; y < image->height; ++y)
+            std::copy_n(&image->texels[(size_t)y * image->width], image->width,
+                &atlas.texels[(size_t)(at.second + y) * atlas.width + at.first]);
+    }
+    for (SoftSprite& s : soft.sprites) s.resolved = false;
+}
+
+void softGetAtlasSize(int& width, int& height) {
+    width = soft.atlas.width;
+    height = soft.atlas.height;
+}
+
+void softDrawSprites(const SpriteQuad* quads, size_t count, const uint16_t* sprites) {
+    for (size_t i = 0; i < count; ++i) {
+        const SpriteQuad& q = quads[i];
+        SoftSprite& s = soft.sprites[sprites[q.texture]];
+        if (!s.resolved) resolveSprite(s);
+        float hw = q.width * soft.poseX * 0.5f, hh = q.height * soft.poseY * 0.5f;
+        float xs[4], ys[4];
+        posePoint(q.x, q.y, -hw, -hh, xs[0], ys[0]);
+        posePoint(q.x, q.y, hw, -hh, xs[1], ys[1]);
+        posePoint(q.x, q.y, hw, hh, xs[2], ys[2]);
+        posePoint(q.x, q.y, -hw, hh, xs[3], ys[3]);
+        const RasterRegion* region = s.texture ? &s.region : nullptr;
+        if (soft.angle != 0.f) soft.raster.fillQuad(xs, ys, s.color, s.texture, region);
+        else soft.raster.fillRect(xs[0], ys[0], xs[2], ys[2], s.color, s.texture, region);
+    }
+}
+
+void softUpdateFrame() {
+    if (soft.update) soft.update(soft.frameMs);
+    soft.timeMs += soft.frameMs;
+    graphics::MouseState& m = soft.mouse;
+    m.button_left_pressed = m.button_middle_pressed = m.button_right_pressed = false;
+    m.button_left_released = m.button_middle_released = m.button_right_released = false;
+    m.prev_pos_x = m.cur_pos_x;
+    m.prev_pos_y = m.cur_pos_y;
+}
+
+void softDrawFrame() {
+    soft.raster.setClip(0, 0, soft.windowWidth, soft.windowHeight);
+    soft.raster.clear(soft.background);
+    // Outside the canvas stays background, as with a real window.
+    if (soft.scaleMode != graphics::CANVAS_SCALE_WINDOW) {
+        soft.raster.setClip((int)std::floor(soft.offsetX + 0.5f), (int)std::floor(soft.offsetY + 0.5f),
+            (int)std::floor(toPixelX(soft.canvasWidth) + 0.5f), (int)std::floor(toPixelY(soft.canvasHeight) + 0.5f));
+    }
+    if (soft.draw) soft.draw();
+}
+
+void softStepFrame() {
+    softUpdateFrame();
+    softDrawFrame();
+}
+
+void softGetFrame(Image& out) {
+    out.width = soft.raster.getWidth();
+    out.height = soft.raster.getHeight();
+    const uint8_t* p = (const uint8_t*)soft.raster.getPixels();
+    out.rgba.assign(p, p + (size_t)out.width * out.height * 4);
+}
+
+bool softSaveFrame(const std::string& path) {
+    Image image;
+    softGetFrame(image);
+    return savePng(nativePath(path), image);
+}
+
+namespace graphics {
+
+void createWindow(int width, int height, std::string) {
+    soft.windowWidth = width;
+    soft.windowHeight = height;
+    if (soft.canvasWidth <= 0.f) {
+        soft.canvasWidth = (float)width;
+        soft.canvasHeight = (float)height;
+    }
+    soft.raster.resize(width, height);
+    soft.running = true;
+    updateTransform();
+}
+
+void setWindowBackground(Brush style) {
+    soft.background = fillColor(style);
+}
+
+void destroyWindow() {
+    soft.running = false;
+}
+
+void startMessageLoop() {
+    for (int frame = 0; soft.running && (soft.frameLimit < 0 || frame < soft.frameLimit); ++frame)
+        softStepFrame();
+}
+
+void stopMessageLoop() {
+    soft.running = false;
+}
+
+void setCanvasSize(float w, float h) {
+    soft.canvasWidth = w;
+    soft.canvasHeight = h;
+    updateTransform();
+}
+
+void setCanvasScaleMode(scale_mode_t sm) {
+    soft.scaleMode = sm;
+    updateTransform();
+}
+
+void setFullScreen(bool) {}
+
+float windowToCanvasX(float x, bool clamped) {
+    float cx = (x - soft.offsetX) / soft.scaleX;
+    float w = soft.scaleMode == CANVAS_SCALE_WINDOW ? (float)soft.windowWidth : soft.canvasWidth;
+    return clamped ? std::min(std::max(cx, 0.f), w) : cx;
+}
+
+float windowToCanvasY(float y, bool clamped) {
+    float cy = (y - soft.offsetY) / soft.scaleY;
+    float h = soft.scaleMode == CANVAS_SCALE_WINDOW ? (float)soft.windowHeight : soft.canvasHeight;
+    return clamped ? std::min(std::max(cy, 0.f), h) : cy;
+}
+
+void setUserData(const void* user_data) { soft.userData = user_data; }
+void* getUserData() { return (void*)soft.userData; }
+void setDrawFunction(std::function<void()> draw) { soft.draw = draw; }
+void setUpdateFunction(std::function<void(float)> update) { soft.update = update; }
+void setResizeFunction(std::function<void(int, int)> resize) { soft.resize = resize; }
+
+void getMouseState(MouseState& ms) { ms = soft.mouse; }
+bool getKeyState(scancode_t key) { return key >= 0 && key < NUM_SCANCODES && soft.keys[key]; }
+float getDeltaTime() { return soft.frameMs; }
+float getGlobalTime() { return (float)soft.timeMs; }
+
+void drawRect(float center_x, float center_y, float width, float height, const Brush& brush) {
+    float hw = width * soft.poseX * 0.5f, hh = height * soft.poseY * 0.5f;
+    RasterColor fill = fillColor(brush);
+    RasterColor line = outlineColor(brush);
+    float xs[4], ys[4];
+    posePoint(center_x, center_y, -hw, -hh, xs[0], ys[0]);
+    posePoint(center_x, center_y, hw, -hh, xs[1], ys[1]);
+    posePoint(center_x, center_y, hw, hh, xs[2], ys[2]);
+    posePoint(center_x, center_y, -hw, hh, xs[3], ys[3]);
+
+    if (fill.a > 0.f) {
+        if (soft.angle != 0.f)
+            soft.raster.fillQuad(xs, ys, fill, getTexture(brush.texture));
+        else if (brush.gradient) {
+            RasterColor second;
+            second.r = brush.fill_secondary_color[0];
+            second.g = brush.fill_secondary_color[1];
+            second.b = brush.fill_secondary_color[2];
+            second.a = brush.fill_secondary_opacity;
+            soft.raster.fillGradient(xs[0], ys[0], xs[2], ys[2], fill, second, brush.gradient_dir_u, brush.gradient_dir_v);
+        }
+        else soft.raster.fillRect(xs[0], ys[0], xs[2], ys[2], fill, getTexture(brush.texture));
+    }
+    if (line.a > 0.f && brush.outline_width > 0.f) {
+        for (int k = 0; k < 4; ++k)
+            strokeSegment(xs[k], ys[k], xs[(k + 1) & 3], ys[(k + 1) & 3], brush.outline_width, line);
+    }
+}
+
+void drawLine(float x1, float y1, float x2, float y2, const Brush& brush) {
+    strokeSegment(toPixelX(x1), toPixelY(y1), toPixelX(x2), toPixelY(y2), brush.outline_width, outlineColor(brush));
+}
+
+void drawDisk(float cx, float cy, float radius, const Brush& brush) {
+    drawSector(cx, cy, 0.f, radius, 0.f, 360.f, brush);
+}
+
+void drawSector(float cx, float cy, float radius1, float radius2, float start_angle, float end_angle, const Brush& brush) {
+    float px = toPixelX(cx), py = toPixelY(cy);
+    float scale = soft.scaleX * soft.poseX;
+    float r0 = radius1 * scale, r1 = radius2 * scale;
+    float a0 = (start_angle + soft.angle) * 0.0174532925f, a1 = (end_angle + soft.angle) * 0.0174532925f;
+    RasterColor fill = fillColor(brush);
+    if (fill.a > 0.f) soft.raster.fillSector(px, py, r0, r1, a0, a1, fill);
+
+    RasterColor line = outlineColor(brush);
+    float w = brush.outline_width * 0.5f;
+    if (line.a <= 0.f || w <= 0.f) return;
+    soft.raster.fillSector(px, py, std::max(r1 - w, 0.f), r1 + w, a0, a1, line);
+    if (r0 > 0.f) soft.raster.fillSector(px, py, std::max(r0 - w, 0.f), r0 + w, a0, a1, line);
+    if (std::fabs(end_angle - start_angle) < 360.f) {
+        for (float a : { a0, a1 }) {
+            float c = std::cos(a), s = -std::sin(a);
+            strokeSegment(px + c * r0, py + s * r0, px + c * r1, py + s * r1, brush.outline_width, line);
+        }
+    }
+}
+
+bool setFont(std::string fontname) {
+    std::ifstream file(nativePath(fontname), std::ios::binary);
+    if (!file) return false;
+    soft.hasFont = true;
+    return true;
+}
+
+void drawText(float pos_x, float pos_y, float size, const std::string& text, const Brush& brush) {
+    if (!soft.hasFont) return;
+    soft.raster.drawText(toPixelX(pos_x), toPixelY(pos_y), size * soft.scaleY * soft.poseY, text, fillColor(brush));
+}
+
+void setOrientation(float angle) { soft.angle = angle; }
+
+void setScale(float sx, float sy) {
+    soft.poseX = sx;
+    soft.poseY = sy;
+}
+
+void resetPose() {
+    soft.angle = 0.f;
+    soft.poseX = soft.poseY = 1.f;
+}
+
+std::vector<std::string> preloadBitmaps(std::string dir) {
+    std::vector<std::string> loaded;
+    std::error_code ec;
+    for (const auto& item : std::filesystem::directory_iterator(nativePath(dir), ec)) {
+        std::string ext = item.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](char ch) { return (char)tolower(ch); });
+        if (ext != ".png") continue;
+        std::string path = dir + "/" + item.path().filename().string();
+        if (!getTexture(path)->texels.empty()) loaded.push_back(path);
+    }
+    return loaded;
+}
+
+void playSound(std::string, float, bool) {}
+void playMusic(std::string, float, bool, int) {}
+void stopMusic(int) {}
+
+}
@@ -0,0 +1,206 @@
+#include "sim.h"
+#include "moves.h"
+#include "simd.h"
+
+FighterHandle FighterStore::add(Scalar px, Scalar py, Scalar moveSpeed) {
+    x.push_back(px);
+    y.push_back(py);
+    vy.push_back(0.f);
+    speed.push_back(moveSpeed);
+    health.push_back(100.f);
+    jumping.push_back(0);
+    anim.push_back(AnimState::IDLE);
+    moveFrame.push_back(0);
+    return (FighterHandle)(x.size() - 1);
+}
+
+void FighterStore::clear() {
+    x.clear(); y.clear(); vy.clear(); speed.clear();
+    health.clear();
+    jumping.clear(); anim.clear();
+    moveFrame.clear();
+}
+
+void FighterStore::reserve(size_t n) {
+    x.reserve(n); y.reserve(n); vy.reserve(n); speed.reserve(n);
+    health.reserve(n);
+    jumping.reserve(n); anim.reserve(n);
+    moveFrame.reserve(n);
+}
+
+// Scalar movement and jump for one fighter; also handles the tail the SIMD loop leaves over.
+static void moveFighter(FighterStore& f, size_t i, uint8_t b, Scalar dt) {
+    Scalar* x = f.x.data();
+    Scalar* y = f.y.data();
+    Scalar* vy = f.vy.data();
+    uint8_t* jumping = f.jumping.data();
+    if (f.anim[i] == AnimState::KO) return;
+
+    if (b & INPUT_LEFT) x[i] -= f.speed[i] * dt;
+    if (b & INPUT_RIGHT) x[i] += f.speed[i] * dt;
+    if (x[i] < 50.f) x[i] = 50.f;
+    if (x[i] > 750.f) x[i] = 750.f;
+
+    if (!jumping[i] && (b & INPUT_JUMP)) { jumping[i] = 1; vy[i] = 300.f; }
+    if (jumping[i]) {
+        y[i] += vy[i] * dt;
+        vy[i] -= 600.f * dt;
+        if (y[i] < 0.f) { y[i] = 0.f; jumping[i] = 0; vy[i] = 0.f; }
+    }
+}
+
+#if KOMBAT_SIMD && !defined(KOMBAT_FIXED_POINT)
+// Four fighters per step. Every branch of moveFighter becomes a lane mask
+// and a blend, doing the same float operations in the same order, so results
+// are bit-identical to the scalar path (replays depend on that).
+static size_t moveFightersSimd(FighterStore& f, const uint8_t* buttons, float dt) {
+    size_t n = f.size() & ~(size_t)3;
+    float* xs = f.x.data();
+    float* ys = f.y.data();
+    float* vys = f.vy.data();
+    const float* speeds = f.speed.data();
+    uint8_t* jumpings = f.jumping.data();
+    const uint8_t* anims = (const uint8_t*)f.anim.data();
+    const __m128 vdt = _mm_set1_ps(dt), zero = _mm_setzero_ps();
+    const __m128 minX = _mm_set1_ps(50.f), maxX = _mm_set1_ps(750.f);
+    const __m128 jumpVy = _mm_set1_ps(300.f), gravity = _mm_set1_ps(600.f * dt);
+    const __m128i zeroi = _mm_setzero_si128(), one = _mm_set1_epi32(1);
+    const __m128i ko = _mm_set1_epi32((int)AnimState::KO);
+
+    for (size_t i = 0; i < n; i += 4) {
+        __m128i b = simdLoadBytes4(buttons + i);
+        __m128i jumpingIn = simdLoadBytes4(jumpings + i);
+        __m128i animIn = simdLoadBytes4(anims + i);
+        __m128i livei = _mm_xor_si128(_mm_cmpeq_epi32(animIn, ko), _mm_set1_epi32(-1));
+        __m128 live = _mm_castsi128_ps(livei);
+        __m128 left = _mm_castsi128_ps(simdHasBits(b, INPUT_LEFT));
+        __m128 right = _mm_castsi128_ps(simdHasBits(b, INPUT_RIGHT));
+        __m128i jump = simdHasBits(b, INPUT_JUMP);
+
+        __m128 x0 = _mm_loadu_ps(xs + i);
+        __m128 step = _mm_mul_ps(_mm_loadu_ps(speeds + i), vdt);
+        __m128 x = simdSelect(left, _mm_sub_ps(x0, step), x0);
+        x = simdSelect(right, _mm_add_ps(x, step), x);
+        x = simdSelect(_mm_cmplt_ps(x, minX), minX, x);
+        x = simdSelect(_mm_cmpgt_ps(x, maxX), maxX, x);
+        _mm_storeu_ps(xs + i, simdSelect(live, x, x0));
+
+        __m128 y0 = _mm_loadu_ps(ys + i), vy0 = _mm_loadu_ps(vys + i);
+        __m128i wasJumping = _mm_xor_si128(_mm_cmpeq_epi32(jumpingIn, zeroi), _mm_set1_epi32(-1));
+        __m128i startJump = _mm_andnot_si128(wasJumping, jump);
+        __m128i jumping = _mm_or_si128(wasJumping, startJump);
+        __m128 vy = simdSelect(_mm_castsi128_ps(startJump), jumpVy, vy0);
+        __m128 airborne = _mm_castsi128_ps(jumping);
+        __m128 y = simdSelect(airborne, _mm_add_ps(y0, _mm_mul_ps(vy, vdt)), y0);
+        vy = simdSelect(airborne, _mm_sub_ps(vy, gravity), vy);
+        __m128 landed = _mm_and_ps(airborne, _mm_cmplt_ps(y, zero));
+        y = simdSelect(landed, zero, y);
+        vy = simdSelect(landed, zero, vy);
+        jumping = _mm_andnot_si128(_mm_castps_si128(landed), jumping);
+        _mm_storeu_ps(ys + i, simdSelect(live, y, y0));
+        _mm_storeu_ps(vys + i, simdSelect(live, vy, vy0));
+        simdStoreBytes4(jumpings + i, simdSelect(livei, _mm_and_si128(jumping, one), jumpingIn));
+    }
+    return n;
+}
+#endif
+
+void updateFighters(FighterStore& f, const uint8_t* buttons, float dt, const MoveTable& moves) {
+    size_t i = 0;
+#if KOMBAT_SIMD && !defined(KOMBAT_FIXED_POINT)
+    i = moveFightersSimd(f, buttons, dt);
+#endif
+    Scalar step = dt;
+    for (size_t n = f.size(); i < n; ++i) moveFighter(f, i, buttons[i], step);
+    moves.step(f, buttons);
+}
+
+void checkHit(FighterStore& f, FighterHandle attacker, FighterHandle target, const MoveTable& moves) {
+    const MoveFrame& fr = moves.getFrame(f.moveFrame[attacker]);
+    Scalar& health = f.health[target];
+    if (!(fr.flags & FRAME_ACTIVE) || health <= 0.f) return;
+    Scalar dx = f.x[target] - f.x[attacker];
+    Scalar dy = f.y[target] - f.y[attacker];
+    // Fighters face each other, and the hitbox is given facing right.
+    Scalar left = fr.hitLeft, right = fr.hitRight;
+    if (dx < 0.f) {
+        left = -fr.hitRight;
+        right = -fr.hitLeft;
+    }
+    if (dx <= left || dx >= right || dy < fr.hitBottom || dy > fr.hitTop) return;
+    if (moves.getFrame(f.moveFrame[target]).flags & FRAME_GUARD) return;
+
+    health -= fr.damage;
+    if (health < 0.f) health = 0.f;
+    if (health <= 0.f) {
+        f.anim[target] = AnimState::KO;
+        f.moveFrame[target] = 0;
+    }
+    if (fr.knockback != 0.f) {
+        Scalar& x = f.x[target];
+        x += dx < 0.f ? -fr.knockback : fr.knockback;
+        if (x < 50.f) x = 50.f;
+        if (x > 750.f) x = 750.f;
+    }
+}
+
+void resolveOverlap(FighterStore& f, FighterHandle a, FighterHandle b) {
+    Scalar r = 30.f;
+    Scalar& xa = f.x[a];
+    Scalar& xb = f.x[b];
+    Scalar dx = xa - xb;
+    Scalar dist = dx < 0.f ? -dx : dx;
+    Scalar overlap = (2 * r) - dist;
+    if (overlap > 0.f) {
+        Scalar half = overlap * 0.5f;
+        if (dx > 0.f) { xa += half; xb -= half; }
+        else { xa -= half; xb += half; }
+    }
+    if (xa > xb) {
+        Scalar mid = (xa + xb) * 0.5f;
+        xa = mid - r; xb = mid + r;
+    }
+}
+
+Simulation::Simulation() : moves(&defaultMoves()) {
+    reset();
+}
+
+void Simulation::setMoves(const MoveTable* table) {
+    moves = table ? table : &defaultMoves();
+}
+
+void Simulation::reset(int duelCount) {
+    duels = duelCount;
+    fighters.clear();
+    fighters.reserve((size_t)duels * 2);
+    for (int d = 0; d < duels; ++d) {
+        fighters.add(200.f, 0.f, params.speed);
+        fighters.add(600.f, 0.f, params.speed);
+    }
+}
+
+void Simulation::update(const uint8_t* buttons, float dt) {
+    updateFighters(fighters, buttons, dt, *moves);
+    const Scalar* health = fighters.health.data();
+    for (int d = 0; d < duels; ++d) {
+        FighterHandle p1 = (FighterHandle)d * 2, p2 = p1 + 1;
+        if (health[p1] > 0.f && health[p2] > 0.f) {
+            checkHit(fighters, p1, p2, *moves);
+            checkHit(fighters, p2, p1, *moves);
+        }
+        resolveOverlap(fighters, p1, p2);
+    }
+}
+
+bool Simulation::isOver(int duel) const {
+    return fighters.health[duel * 2] <= 0.f || fighters.health[duel * 2 + 1] <= 0.f;
+}
+
+int Simulation::getWinner(int duel) const {
+    bool alive1 = fighters.health[duel * 2] > 0.f;
+    bool alive2 = fighters.health[duel * 2 + 1] > 0.f;
+    if (alive1 && !alive2) return 0;
+    if (alive2 && !alive1) return 1;
+    return -1;
+}
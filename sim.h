@@ -0,0 +1,88 @@
+#pragma once
+#include "fixed.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fight simulation with no SGG dependency. Everything the fight needs for a
+// tick comes in through TickInput, so it can be stepped headless. Positions,
+// velocities and health are Scalar: float by default, Fixed in builds with
+// KOMBAT_FIXED_POINT (fixed.h).
+
+// The simulation always advances in steps of SIM_DT, independent of the render rate.
+const int SIM_HZ = 120;
+const float SIM_DT = 1.f / SIM_HZ;
+
+enum class AnimState : uint8_t { IDLE, PUNCHING, KO };
+
+enum InputBits : uint8_t {
+    INPUT_LEFT = 1 << 0,
+    INPUT_RIGHT = 1 << 1,
+    INPUT_JUMP = 1 << 2,
+    INPUT_PUNCH = 1 << 3
+};
+
+struct TickInput {
+    uint8_t buttons[2] = { 0, 0 };
+};
+
+// Balance values outside the move table. The defaults are the shipped tuning;
+// the batch runner overrides them to test changes.
+struct FightParams {
+    float speed = 200.f;
+};
+
+class MoveTable;
+
+// Index of a fighter in the FighterStore. Handles stay valid until the store is cleared.
+typedef uint32_t FighterHandle;
+
+// Fighter state kept as parallel arrays, one entry per handle, so the tick
+// walks contiguous memory instead of chasing per-object pointers.
+struct FighterStore {
+    std::vector<Scalar> x, y, vy, speed;
+    std::vector<Scalar> health;
+    std::vector<uint8_t> jumping;
+    std::vector<AnimState> anim;
+    // Index into the MoveTable's frames; 0 while no move is in progress.
+    std::vector<uint16_t> moveFrame;
+
+    FighterHandle add(Scalar px, Scalar py, Scalar moveSpeed = 200.f);
+    void clear();
+    void reserve(size_t n);
+    size_t size() const { return x.size(); }
+};
+
+void updateFighters(FighterStore& f, const uint8_t* buttons, float dt, const MoveTable& moves);
+// Applies the attacker's current move frame to the target, if it is active and in range.
+void checkHit(FighterStore& f, FighterHandle attacker, FighterHandle target, const MoveTable& moves);
+void resolveOverlap(FighterStore& f, FighterHandle a, FighterHandle b);
+
+// Runs one or more independent duels. Duel d is fought between handles 2d and 2d+1.
+class Simulation {
+private:
+    FighterStore fighters;
+    FightParams params;
+    const MoveTable* moves;
+    int duels = 1;
+public:
+    Simulation();
+
+    void reset(int duelCount = 1);
+    // Takes effect for fighters spawned by the next reset.
+    void setParams(const FightParams& p) { params = p; }
+    const FightParams& getParams() const { return params; }
+    // The table must outlive the simulation; nullptr means defaultMoves().
+    void setMoves(const MoveTable* table);
+    const MoveTable& getMoves() const { return *moves; }
+    // buttons holds one byte of InputBits per fighter handle.
+    void update(const uint8_t* buttons, float dt);
+    void update(const TickInput& input, float dt) { update(input.buttons, dt); }
+
+    FighterStore& getFighters() { return fighters; }
+    const FighterStore& getFighters() const { return fighters; }
+    int getDuelCount() const { return duels; }
+    bool isOver(int duel = 0) const;
+    // 0 or 1 for the surviving side of the duel, -1 while it is running or on a double KO.
+    int getWinner(int duel = 0) const;
+};
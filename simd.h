@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+// SSE2 helpers shared by the vectorized kernels. SSE2 is part of every x64
+// target; define KOMBAT_NO_SIMD to force the scalar paths, e.g. to check
+// they still agree.
+
+#if !defined(KOMBAT_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define KOMBAT_SIMD 1
+
+// Widens four bytes to four 32-bit lanes.
+inline __m128i simdLoadBytes4(const uint8_t* p) {
+    int32_t v;
+    memcpy(&v, p, 4);
+    __m128i zero = _mm_setzero_si128();
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero), zero);
+}
+
+// Narrows four 32-bit lanes holding 0..255 back to bytes.
+inline void simdStoreBytes4(uint8_t* p, __m128i v) {
+    int32_t out = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(v, v), v));
+    memcpy(p, &out, 4);
+}
+
+// mask ? a : b, per lane.
+inline __m128 simdSelect(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+inline __m128i simdSelect(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// All-ones in lanes where (v & bits) == bits.
+inline __m128i simdHasBits(__m128i v, int bits) {
+    __m128i b = _mm_set1_epi32(bits);
+    return _mm_cmpeq_epi32(_mm_and_si128(v, b), b);
+}
+#else
+#define KOMBAT_SIMD 0
+#endif
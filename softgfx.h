@@ -0,0 +1,52 @@
+#pragma once
+#include "png.h"
+#include "raster.h"
+#include "sgg/graphics.h"
+#include <cstdint>
+#include <string>
+
+struct SpriteQuad;
+
+// Extras of the software SGG backend (sgg_soft.cpp), which implements
+// graphics.h over a Rasterizer for builds without lib/sgg.lib. There is no
+// window: the "window" is the framebuffer, the clock advances a fixed time per
+// frame, and keys and the mouse are whatever was last set here. Sounds are
+// accepted and ignored.
+
+// startMessageLoop() returns after this many frames; below 0 (the default)
+// it runs until stopMessageLoop() or destroyWindow().
+void softSetFrameLimit(int frames);
+// Milliseconds each frame adds to the clock; 1000/60 by default.
+void softSetFrameTime(float ms);
+void softSetKey(graphics::scancode_t key, bool down);
+// Seen by the next frame's update; the pressed and released flags then clear.
+void softSetMouse(const graphics::MouseState& ms);
+// One update and draw, for callers that drive frames themselves.
+void softStepFrame();
+// The two halves of softStepFrame(): the update callback and clock, then
+// clearing the framebuffer and calling the draw callback.
+void softUpdateFrame();
+void softDrawFrame();
+// Asked for a texture's pixels before its file is decoded; returns false to
+// fall back to the file. The pixels are copied, so they need not outlive the call.
+typedef bool (*SoftImageSource)(void* user, const std::string& path, const uint8_t*& rgba, int& width, int& height);
+void softSetImageSource(SoftImageSource source, void* user);
+// SpriteBatch's path on this backend. Sprites are registered once: a whole
+// image, one cell of an image cut into a cols x rows grid, or a flat colour.
+// A sorted list of quads is then drawn in one call instead of a drawRect
+// each. softBuildAtlas() copies the images of every sprite registered so far
+// into one texture, which the sprites sample from then on; before it, and
+// for sprites added after it, each samples its own image.
+uint16_t softAddSprite(const std::string& image, int col = 0, int row = 0, int cols = 1, int rows = 1);
+uint16_t softAddColorSprite(float r, float g, float b);
+void softBuildAtlas(int maxWidth = 2048);
+// Atlas size in texels, 0 x 0 before softBuildAtlas().
+void softGetAtlasSize(int& width, int& height);
+// sprites[q.texture] is the sprite each quad draws.
+void softDrawSprites(const SpriteQuad* quads, size_t count, const uint16_t* sprites);
+const Rasterizer& softGetRasterizer();
+// Resets the rasterizer's counters, e.g. before drawing a frame to measure.
+void softResetStats();
+void softGetFrame(Image& out);
+// Writes the framebuffer as a PNG.
+bool softSaveFrame(const std::string& path);
@@ -0,0 +1,98 @@
+#include "spritebatch.h"
+#ifdef KOMBAT_SOFT_GFX
+#include "softgfx.h"
+#endif
+#include <algorithm>
+
+TextureId SpriteBatch::registerTexture(const std::string& path) {
+    if (path.empty()) return NO_TEXTURE;
+    for (size_t i = 0; i < paths.size(); ++i)
+        if (paths[i] == path) return (TextureId)i;
+
+    paths.push_back(path);
+    graphics::Brush br;
+    br.outline_opacity = 0.f;
+    br.texture = path;
+    brushes.push_back(br);
+#ifdef KOMBAT_SOFT_GFX
+    sprites.push_back(softAddSprite(path));
+#endif
+    return (TextureId)(paths.size() - 1);
+}
+
+TextureId SpriteBatch::registerCell(const std::string& sheetPath, int col, int row, int cols, int rows,
+    const std::string& cellPath) {
+    for (size_t i = 0; i < paths.size(); ++i)
+        if (paths[i] == cellPath) return (TextureId)i;
+
+    paths.push_back(cellPath);
+    graphics::Brush br;
+    br.outline_opacity = 0.f;
+    br.texture = cellPath;
+    brushes.push_back(br);
+#ifdef KOMBAT_SOFT_GFX
+    sprites.push_back(softAddSprite(sheetPath, col, row, cols, rows));
+#endif
+    return (TextureId)(paths.size() - 1);
+}
+
+TextureId SpriteBatch::registerColor(float r, float g, float b) {
+    paths.push_back(std::string());
+    graphics::Brush br;
+    br.outline_opacity = 0.f;
+    br.fill_color[0] = r;
+    br.fill_color[1] = g;
+    br.fill_color[2] = b;
+    brushes.push_back(br);
+#ifdef KOMBAT_SOFT_GFX
+    sprites.push_back(softAddColorSprite(r, g, b));
+#endif
+    return (TextureId)(paths.size() - 1);
+}
+
+TextId SpriteBatch::registerText(const std::string& text) {
+    texts.push_back(text);
+    return (TextId)(texts.size() - 1);
+}
+
+void SpriteBatch::preload(TextureId id) {
+    graphics::drawRect(-100.f, -100.f, 1.f, 1.f, brushes[id]);
+}
+
+void SpriteBatch::buildAtlas() {
+#ifdef KOMBAT_SOFT_GFX
+    softBuildAtlas();
+#endif
+}
+
+void QuadList::sort() {
+    // std::sort with the submission order as the last key, since
+    // std::stable_sort allocates a scratch buffer on every call. Callers
+    // usually submit in order already, which the check finds in one pass.
+    auto before = [](const SpriteQuad& a, const SpriteQuad& b) {
+        if (a.layer != b.layer) return a.layer < b.layer;
+        if (a.texture != b.texture) return a.texture < b.texture;
+        return a.seq < b.seq;
+    };
+    if (!std::is_sorted(quads.begin(), quads.end(), before))
+        std::sort(quads.begin(), quads.end(), before);
+}
+
+void SpriteBatch::flush() {
+    quads.sort();
+    draw(quads);
+    quads.clear();
+}
+
+void SpriteBatch::draw(const QuadList& list) {
+#ifdef KOMBAT_SOFT_GFX
+    softDrawSprites(list.begin(), list.size(), sprites.data());
+    drawCalls = list.size() ? 1 : 0;
+#else
+    drawCalls = 0;
+    for (const SpriteQuad& q : list) {
+        graphics::drawRect(q.x, q.y, q.width, q.height, brushes[q.texture]);
+        ++drawCalls;
+    }
+#endif
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "sgg/graphics.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Collects a frame's textured quads and submits them in one pass, grouped by
+// texture. Textures are registered once at load time and referenced by
+// integer TextureId afterwards, so the draw path never builds path strings.
+// SGG binds whole image files, so there each quad is still one drawRect; it
+// reuses a prebuilt Brush per texture, and quads are ordered to keep texture
+// switches to one per texture per layer. The soft backend packs the images
+// into one atlas and takes the whole list in a single call.
+
+typedef uint16_t TextureId;
+const TextureId NO_TEXTURE = 0xffff;
+typedef uint16_t TextId;
+
+struct SpriteQuad {
+    float x, y, width, height;   // center and size in canvas units, as drawRect
+    TextureId texture;
+    uint8_t layer;
+    uint32_t seq;                // submission order, keeps the sort stable
+};
+
+// A frame's quads, built without calling SGG so it can be filled on another
+// thread and handed to SpriteBatch::draw() later.
+class QuadList {
+private:
+    std::vector<SpriteQuad> quads;
+public:
+    void add(TextureId texture, float x, float y, float width, float height, uint8_t layer = 0) {
+        if (texture != NO_TEXTURE) quads.push_back({ x, y, width, height, texture, layer, (uint32_t)quads.size() });
+    }
+    // Orders by layer, then texture, then submission.
+    void sort();
+    void clear() { quads.clear(); }
+    size_t size() const { return quads.size(); }
+    const SpriteQuad* begin() const { return quads.data(); }
+    const SpriteQuad* end() const { return quads.data() + quads.size(); }
+};
+
+class SpriteBatch {
+private:
+    std::vector<std::string> paths;
+    std::vector<graphics::Brush> brushes;
+#ifdef KOMBAT_SOFT_GFX
+    std::vector<uint16_t> sprites;   // soft backend sprite per TextureId
+#endif
+    QuadList quads;
+    std::vector<std::string> texts;
+    int drawCalls = 0;
+public:
+    TextureId registerTexture(const std::string& path);
+    // Cell (col, row) of a sheet cut into cols x rows. SGG draws cellPath, the
+    // cell cut out to a file of its own; the soft backend samples the cell's
+    // region of the sheet in its atlas.
+    TextureId registerCell(const std::string& sheetPath, int col, int row, int cols, int rows,
+        const std::string& cellPath);
+    // A solid-colour brush with no image, drawn like any texture.
+    TextureId registerColor(float r, float g, float b);
+    const std::string& getPath(TextureId id) const { return paths[id]; }
+    TextureId getTextureCount() const { return (TextureId)paths.size(); }
+    // Draws the texture once outside the canvas so the backend loads it now.
+    void preload(TextureId id);
+    // Packs every registered image into the backend's atlas. Call once the
+    // images can be loaded; a no-op on SGG.
+    void buildAtlas();
+
+    void add(TextureId texture, float x, float y, float width, float height, uint8_t layer = 0) {
+        quads.add(texture, x, y, width, height, layer);
+    }
+    QuadList& getQuads() { return quads; }
+    // Sorts the pending quads by layer then texture and draws them.
+    void flush();
+    // Draws a list that is already sorted, leaving it untouched.
+    void draw(const QuadList& list);
+    int getDrawCalls() const { return drawCalls; }
+
+    // Strings for drawText are kept here too, so each frame passes SGG a
+    // stored std::string instead of building one from a char pointer.
+    TextId registerText(const std::string& text);
+    // Overwrites the stored text; no allocation once its capacity fits.
+    void setText(TextId id, const char* text) { texts[id].assign(text); }
+    const std::string& getText(TextId id) const { return texts[id]; }
+    // Draws right away, unlike add().
+    void drawText(TextId id, float x, float y, float size, const graphics::Brush& br) const {
+        graphics::drawText(x, y, size, texts[id], br);
+    }
+};
@@ -0,0 +1,208 @@
+#include "statehash.h"
+#include <cstring>
+
+static const char* const FIELD_NAMES[STATE_FIELDS] = {
+    "x", "y", "vy", "speed", "health", "jumping", "anim", "moveFrame"
+};
+
+const char* stateFieldName(int field) {
+    return field >= 0 && field < STATE_FIELDS ? FIELD_NAMES[field] : "?";
+}
+
+static const uint64_t P1 = 0x9E3779B185EBCA87ull;
+static const uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t P3 = 0x165667B19E3779F9ull;
+static const uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t P5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t rotl64(uint64_t v, int r) { return (v << r) | (v >> (64 - r)); }
+
+static inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint64_t xxhRound(uint64_t acc, uint64_t input) {
+    acc += input * P2;
+    return rotl64(acc, 31) * P1;
+}
+
+static inline uint64_t xxhMerge(uint64_t acc, uint64_t v) {
+    acc ^= xxhRound(0, v);
+    return acc * P1 + P4;
+}
+
+uint64_t xxh64(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* p = (const uint8_t*)data;
+    const uint8_t* end = p + size;
+    uint64_t h;
+    if (size >= 32) {
+        uint64_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+        for (; p + 32 <= end; p += 32) {
+            v1 = xxhRound(v1, read64(p));
+            v2 = xxhRound(v2, read64(p + 8));
+            v3 = xxhRound(v3, read64(p + 16));
+            v4 = xxhRound(v4, read64(p + 24));
+        }
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxhMerge(h, v1);
+        h = xxhMerge(h, v2);
+        h = xxhMerge(h, v3);
+        h = xxhMerge(h, v4);
+    }
+    else {
+        h = seed + P5;
+    }
+    h += size;
+    for (; p + 8 <= end; p += 8)
+        h = rotl64(h ^ xxhRound(0, read64(p)), 27) * P1 + P4;
+    if (p + 4 <= end) {
+        h = rotl64(h ^ (read32(p) * P1), 23) * P2 + P3;
+        p += 4;
+    }
+    for (; p < end; ++p)
+        h = rotl64(h ^ (*p * P5), 11) * P1;
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+
+int StateHash::firstDifference(const StateHash& o) const {
+    for (int i = 0; i < STATE_FIELDS; ++i)
+        if (fields[i] != o.fields[i]) return i;
+    return -1;
+}
+
+template<typename T>
+static uint32_t hashField(const std::vector<T>& v, int field) {
+    return (uint32_t)xxh64(v.data(), v.size() * sizeof(T), (uint64_t)field);
+}
+
+void hashState(const Simulation& sim, StateHash& out) {
+    const FighterStore& f = sim.getFighters();
+    out.fields[FIELD_X] = hashField(f.x, FIELD_X);
+    out.fields[FIELD_Y] = hashField(f.y, FIELD_Y);
+    out.fields[FIELD_VY] = hashField(f.vy, FIELD_VY);
+    out.fields[FIELD_SPEED] = hashField(f.speed, FIELD_SPEED);
+    out.fields[FIELD_HEALTH] = hashField(f.health, FIELD_HEALTH);
+    out.fields[FIELD_JUMPING] = hashField(f.jumping, FIELD_JUMPING);
+    out.fields[FIELD_ANIM] = hashField(f.anim, FIELD_ANIM);
+    out.fields[FIELD_MOVE_FRAME] = hashField(f.moveFrame, FIELD_MOVE_FRAME);
+    out.combined = xxh64(out.fields, sizeof(out.fields));
+}
+
+template<typename T>
+static double fieldValue(T v) { return (double)v; }
+#ifdef KOMBAT_FIXED_POINT
+static double fieldValue(Fixed v) { return (double)v.getRaw() / Fixed::ONE; }
+#endif
+
+template<typename T>
+static bool diffField(const std::vector<T>& a, const std::vector<T>& b, int field, std::string& out) {
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (memcmp(&a[i], &b[i], sizeof(T)) == 0) continue;
+        char text[128];
+        snprintf(text, sizeof(text), "%s[%zu]: %.9g vs %.9g", stateFieldName(field), i, fieldValue(a[i]), fieldValue(b[i]));
+        out = text;
+        return true;
+    }
+    return false;
+}
+
+std::string describeDifference(const Simulation& a, const Simulation& b) {
+    const FighterStore& fa = a.getFighters();
+    const FighterStore& fb = b.getFighters();
+    if (fa.size() != fb.size())
+        return "fighters: " + std::to_string(fa.size()) + " vs " + std::to_string(fb.size());
+    std::string out;
+    diffField(fa.x, fb.x, FIELD_X, out) || diffField(fa.y, fb.y, FIELD_Y, out) ||
+        diffField(fa.vy, fb.vy, FIELD_VY, out) || diffField(fa.speed, fb.speed, FIELD_SPEED, out) ||
+        diffField(fa.health, fb.health, FIELD_HEALTH, out) || diffField(fa.jumping, fb.jumping, FIELD_JUMPING, out) ||
+        diffField(fa.anim, fb.anim, FIELD_ANIM, out) || diffField(fa.moveFrame, fb.moveFrame, FIELD_MOVE_FRAME, out);
+    return out;
+}
+
+static void putU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void encodeHeader(uint32_t count, uint8_t* out) {
+    memset(out, 0, HASH_LOG_HEADER_SIZE);
+    memcpy(out, "KARH", 4);
+    out[4] = (uint8_t)HASH_LOG_VERSION; out[5] = (uint8_t)(HASH_LOG_VERSION >> 8);
+    out[6] = (uint8_t)SIM_HZ; out[7] = (uint8_t)(SIM_HZ >> 8);
+    putU32(out + 8, count);
+    out[12] = SCALAR_MODE;
+}
+
+bool HashLogWriter::open(const std::string& path) {
+    close();
+    file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    count = 0;
+    uint8_t raw[HASH_LOG_HEADER_SIZE];
+    encodeHeader(0, raw);
+    fwrite(raw, 1, sizeof(raw), file);
+    return true;
+}
+
+void HashLogWriter::write(const StateHash& h) {
+    if (!file) return;
+    uint8_t raw[HASH_LOG_ENTRY_SIZE];
+    for (int i = 0; i < STATE_FIELDS; ++i) putU32(raw + i * 4, h.fields[i]);
+    putU32(raw + STATE_FIELDS * 4, (uint32_t)h.combined);
+    putU32(raw + STATE_FIELDS * 4 + 4, (uint32_t)(h.combined >> 32));
+    fwrite(raw, 1, sizeof(raw), file);
+    ++count;
+}
+
+void HashLogWriter::close() {
+    if (!file) return;
+    uint8_t raw[HASH_LOG_HEADER_SIZE];
+    encodeHeader(count, raw);
+    fseek(file, 0, SEEK_SET);
+    fwrite(raw, 1, sizeof(raw), file);
+    fclose(file);
+    file = nullptr;
+}
+
+bool HashLogReader::open(const std::string& path) {
+    close();
+    file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    uint8_t raw[HASH_LOG_HEADER_SIZE];
+    if (fread(raw, 1, sizeof(raw), file) != sizeof(raw) || memcmp(raw, "KARH", 4) != 0 ||
+        (raw[4] | (raw[5] << 8)) != HASH_LOG_VERSION || (raw[6] | (raw[7] << 8)) != SIM_HZ || raw[12] != SCALAR_MODE) {
+        close();
+        return false;
+    }
+    count = getU32(raw + 8);
+    return true;
+}
+
+void HashLogReader::close() {
+    if (file) fclose(file);
+    file = nullptr;
+}
+
+bool HashLogReader::read(StateHash& h) {
+    uint8_t raw[HASH_LOG_ENTRY_SIZE];
+    if (!file || fread(raw, 1, sizeof(raw), file) != sizeof(raw)) return false;
+    for (int i = 0; i < STATE_FIELDS; ++i) h.fields[i] = getU32(raw + i * 4);
+    h.combined = getU32(raw + STATE_FIELDS * 4) | ((uint64_t)getU32(raw + STATE_FIELDS * 4 + 4) << 32);
+    return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "sim.h"
+#include <cstdio>
+#include <string>
+
+// Per-tick fingerprint of a Simulation, for catching desyncs on the tick
+// they happen. Each FighterStore array is hashed on its own with XXH64 and
+// the combined hash is XXH64 of those field hashes, so two logs that
+// disagree also say which field disagreed. Fight params and the move table
+// are fixed for a match and not part of the hash.
+
+enum StateField {
+    FIELD_X, FIELD_Y, FIELD_VY, FIELD_SPEED, FIELD_HEALTH,
+    FIELD_JUMPING, FIELD_ANIM, FIELD_MOVE_FRAME,
+    STATE_FIELDS
+};
+
+const char* stateFieldName(int field);
+
+uint64_t xxh64(const void* data, size_t size, uint64_t seed = 0);
+
+struct StateHash {
+    uint32_t fields[STATE_FIELDS] = {};
+    uint64_t combined = 0;
+
+    bool operator==(const StateHash& o) const { return combined == o.combined; }
+    bool operator!=(const StateHash& o) const { return combined != o.combined; }
+    // First field whose hash differs, or -1.
+    int firstDifference(const StateHash& o) const;
+};
+
+void hashState(const Simulation& sim, StateHash& out);
+inline uint64_t hashState(const Simulation& sim) {
+    StateHash h;
+    hashState(sim, h);
+    return h.combined;
+}
+
+// "health[1]: 64 vs 70" for the first field and fighter where a and b
+// differ, or an empty string when they match.
+std::string describeDifference(const Simulation& a, const Simulation& b);
+
+// Sidecar to a replay (the replay's path + ".hash"): the StateHash after
+// every tick, so the log of one machine can be checked against another's
+// without rerunning either. After a 16-byte header, each tick is
+// STATE_FIELDS little-endian u32 field hashes then the u64 combined hash.
+//
+// Header: char[4] "KARH", u16 version, u16 sim hz, u32 tick count (patched
+// on close), u8 scalar mode (SCALAR_MODE), u8[3] padding. Logs from a build
+// with the other scalar mode are rejected on open.
+
+const uint16_t HASH_LOG_VERSION = 2;
+const int HASH_LOG_HEADER_SIZE = 16;
+const int HASH_LOG_ENTRY_SIZE = STATE_FIELDS * 4 + 8;
+
+inline std::string hashLogPath(const std::string& replayPath) { return replayPath + ".hash"; }
+
+class HashLogWriter {
+private:
+    FILE* file = nullptr;
+    uint32_t count = 0;
+public:
+    ~HashLogWriter() { close(); }
+
+    bool open(const std::string& path);
+    bool isOpen() const { return file != nullptr; }
+    void write(const StateHash& h);
+    void close();
+};
+
+class HashLogReader {
+private:
+    FILE* file = nullptr;
+    uint32_t count = 0;
+public:
+    ~HashLogReader() { close(); }
+
+    bool open(const std::string& path);
+    void close();
+    uint32_t getTickCount() const { return count; }
+    // Reads the next tick's hash; false at the end of the log.
+    bool read(StateHash& h);
+};